@@ -6,22 +6,23 @@
 #include <locale.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 
 #ifdef _WIN32
 #include <windows.h>
 #endif
 
-bool app_init(AppState *app) {
-  setlocale(LC_ALL, "");
-#ifdef _WIN32
-  SetConsoleOutputCP(CP_UTF8);
-  SetConsoleCP(CP_UTF8);
-#endif
-
-  *app = (AppState){0}; // Zero out the structure
+// How often the trash is checked against the retention policy once a
+// maintenance run has nothing left to do.
+#define MAINTENANCE_INTERVAL_SECONDS 600
 
-  config_load(&app->config);
-  theme_load_external();
+// Opens the database file with the storage profile selected in the config.
+static bool open_database(const AppConfig *config, Database *db) {
+  StorageProfile profile = STORAGE_DEFAULT_PROFILE;
+  if (!database_profile_from_name(config->storage_profile, &profile)) {
+    fprintf(stderr, "Unknown storage profile '%s', using '%s'.\n",
+            config->storage_profile, database_profile_name(profile));
+  }
 
   char db_path[MAX_PATH];
   if (get_database_path(db_path, sizeof(db_path))) {
@@ -35,16 +36,52 @@ bool app_init(AppState *app) {
     return false;
   }
 
-  if (database_init(db_conn, &app->db) != ORDO_OK) {
-    sqlite3_close(db_conn);
+  // On failure database_init has already closed the connection.
+  if (database_init(db_conn, profile, db) != ORDO_OK) {
+    return false;
+  }
+  return true;
+}
+
+bool app_init(AppState *app) {
+  setlocale(LC_ALL, "");
+#ifdef _WIN32
+  SetConsoleOutputCP(CP_UTF8);
+  SetConsoleCP(CP_UTF8);
+#endif
+
+  *app = (AppState){0}; // Zero out the structure
+
+  config_load(&app->config);
+  theme_load_external();
+
+  // The writer thread gets a connection of its own.
+  Database writer_db;
+  if (!open_database(&app->config, &app->db)) {
+    return false;
+  }
+  if (!open_database(&app->config, &writer_db) ||
+      writer_start(&app->writer, &writer_db) != ORDO_OK) {
+    fprintf(stderr, "Error starting the database writer.\n");
+    database_close(&app->db);
     return false;
   }
 
   i18n_init(app->config.lang);
   ui_init(&app->config);
-  timeout(1000); // Para o getch() não bloquear indefinidamente
+
+  // The main loop sleeps on these sources instead of waking every second.
+  event_loop_init(&app->events);
+  event_loop_watch_writer(&app->events, writer_event_fd(&app->writer));
+  char db_path[MAX_PATH];
+  if (!get_database_path(db_path, sizeof(db_path))) {
+    event_loop_watch_database(&app->events, db_path);
+  }
 
   task_list_init(&app->task_list);
+  app->task_list.windowed = app->config.windowed_loading;
+  task_marks_init(&app->marks);
+  task_marks_init(&app->held_marks);
   undo_manager_init(&app->undo_manager);
 
   app->current_view = VIEW_MAIN;
@@ -55,9 +92,157 @@ bool app_init(AppState *app) {
 }
 
 void app_destroy(AppState *app) {
+  writer_stop(&app->writer); // Commits whatever is still queued
+  event_loop_free(&app->events);
   task_list_free(&app->task_list);
+  task_marks_free(&app->marks);
+  task_marks_free(&app->held_marks);
+  undo_manager_destroy(&app->undo_manager);
   ui_destroy();
   database_close(&app->db);
   i18n_destroy();
   theme_free_external();
 }
+
+void app_process_write_acks(AppState *app) {
+  WriteAck ack;
+  while (writer_poll_ack(&app->writer, &ack)) {
+    if (ack.op == DB_WRITE_PURGE) {
+      // Keep going on the next idle tick while there is work left.
+      bool more = ack.result == ORDO_OK && ack.more;
+      app->next_maintenance =
+          time(NULL) + (more ? 0 : MAINTENANCE_INTERVAL_SECONDS);
+      writer_free_ack(&ack);
+      continue;
+    }
+
+    writer_apply_ack(&ack, &app->task_list);
+    if (ack.result == ORDO_OK && ack.op == DB_WRITE_ADD) {
+      undo_manager_remap_id(&app->undo_manager, ack.provisional_id,
+                            ack.task_id);
+      task_marks_rename(&app->marks, ack.provisional_id, ack.task_id);
+      task_marks_rename(&app->held_marks, ack.provisional_id, ack.task_id);
+    }
+
+    if (ack.seq == app->held_marks_seq) {
+      if (ack.result != ORDO_OK && app->marks.count == 0) {
+        TaskMarks marks = app->marks; // Mark the tasks again
+        app->marks = app->held_marks;
+        app->held_marks = marks;
+      }
+      task_marks_clear(&app->held_marks);
+      app->held_marks_seq = 0;
+    }
+
+    if (ack.result != ORDO_OK) {
+      // The optimistic patch is not reverted: commands queued after it may
+      // have patched the same rows, and the writer keeps no old rows to go
+      // back to. Reloading shows what was committed. Writes only fail on I/O
+      // errors, a full disk or a lock held past the busy timeout.
+      undo_manager_drop(&app->undo_manager, ack.seq);
+      ui_show_message(ack.result == ORDO_ERROR_TASK_NOT_FOUND
+                          ? "TASK_NOT_FOUND"
+                          : "SAVE_FAILED",
+                      true, &app->config);
+      app->refresh_tasks = true;
+    } else if (ack.missing > 0) {
+      app->refresh_tasks = true; // Some of the tasks changed elsewhere
+    }
+    writer_free_ack(&ack);
+  }
+}
+
+void app_hold_marks(AppState *app, unsigned long seq) {
+  TaskMarks marks = app->held_marks;
+  app->held_marks = app->marks;
+  app->marks = marks;
+  task_marks_clear(&app->marks);
+  app->held_marks_seq = seq;
+}
+
+void app_sync_writes(AppState *app) {
+  writer_flush(&app->writer);
+  app_process_write_acks(app);
+}
+
+void app_sync_external_changes(AppState *app) {
+  if (writer_busy(&app->writer)) {
+    return;
+  }
+  if (database_sync_changes(&app->db, &app->task_list) != ORDO_OK) {
+    app->refresh_tasks = true;
+  }
+}
+
+int app_selected_task_id(const AppState *app) {
+  if (app->task_list.deleted_scope != (app->current_view == VIEW_TRASH))
+    return -1; // The list still holds the view being left
+  const Task *selected =
+      task_list_at(&app->task_list, app->current_selection);
+  return selected ? selected->id : -1;
+}
+
+void app_select_task(AppState *app, int task_id) {
+  int position;
+  if (task_id >= 0 && database_find_position(&app->db, &app->task_list,
+                                             task_id, &position) == ORDO_OK)
+    app->current_selection = position;
+}
+
+void app_run_maintenance(AppState *app) {
+  if (time(NULL) < app->next_maintenance || writer_busy(&app->writer)) {
+    return;
+  }
+  TrashRetention policy = {app->config.trash_retention_days,
+                           app->config.trash_max_tasks};
+  // Rescheduled when the step is acknowledged; until then the writer is busy.
+  if (writer_purge_trash(&app->writer, &policy, NULL) != ORDO_OK) {
+    app->next_maintenance = time(NULL) + MAINTENANCE_INTERVAL_SECONDS;
+  }
+}
+
+int app_print_db_info(void) {
+  setlocale(LC_ALL, "");
+
+  AppConfig config;
+  config_load(&config);
+
+  Database db;
+  if (!open_database(&config, &db)) {
+    return 1;
+  }
+
+  char db_path[MAX_PATH];
+  if (!get_database_path(db_path, sizeof(db_path))) {
+    printf("Database: %s\n", db_path);
+  }
+  database_print_storage_info(&db, stdout);
+  bool plans_ok = database_check_query_plans(&db, stdout);
+  database_close(&db);
+  return plans_ok ? 0 : 1;
+}
+
+int app_compact_db(void) {
+  setlocale(LC_ALL, "");
+
+  AppConfig config;
+  config_load(&config);
+
+  Database db;
+  if (!open_database(&config, &db)) {
+    return 1;
+  }
+
+  char db_path[MAX_PATH];
+  if (!get_database_path(db_path, sizeof(db_path))) {
+    printf("Compacting %s...\n", db_path);
+  }
+  OrdoResult result = database_compact(&db);
+  database_close(&db);
+  if (result != ORDO_OK) {
+    fprintf(stderr, "Failed to compact the database.\n");
+    return 1;
+  }
+  printf("Done.\n");
+  return 0;
+}
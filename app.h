@@ -11,10 +11,14 @@
 
 #include "config.h"
 #include "database.h"
+#include "event_loop.h"
 #include "task_list.h"
+#include "task_marks.h"
 #include "undo_manager.h"
+#include "writer.h"
 #include <stdbool.h>
 #include <sqlite3.h>
+#include <time.h>
 
 /**
  * @enum AppView
@@ -33,17 +37,23 @@ typedef enum {
  * the database handler, settings, task lists, and UI state.
  */
 typedef struct AppState {
-  Database db;                  /**< Database handler. */
+  Database db;                  /**< Database handler, used by the UI thread for reads. */
+  Writer writer;                /**< Background writer for every mutation. */
   AppConfig config;             /**< Application settings (theme, language). */
   TaskList task_list;           /**< The currently displayed task list. */
+  TaskMarks marks;              /**< Tasks marked for a multi-task action. */
+  TaskMarks held_marks;         /**< The marks of the last multi-task action, until its write is acknowledged. */
+  unsigned long held_marks_seq; /**< The write `held_marks` wait for, or 0. */
   UndoManager undo_manager;     /**< Manager for undo/redo actions. */
+  EventLoop events;             /**< What the main loop sleeps on between frames. */
 
   AppView current_view;         /**< The current view (screen). */
   int current_selection;        /**< The index of the currently selected task. */
   int scroll_offset;            /**< The scroll offset in the task list. */
 
   bool should_exit;             /**< Flag to signal the end of the application. */
-  bool refresh_tasks;           /**< Flag to signal the need to reload tasks from the DB. */
+  bool refresh_tasks;           /**< Flag to signal a full reload (resync) of tasks from the DB. */
+  time_t next_maintenance;      /**< When the next trash maintenance step may run. */
 } AppState;
 
 // --- Lifecycle Functions ---
@@ -69,4 +79,103 @@ bool app_init(AppState *app);
  */
 void app_destroy(AppState *app);
 
+/**
+ * @brief Collects the acknowledgements of the background writer.
+ *
+ * Applies new task IDs and rows the task list was missing. A failed write
+ * leaves the optimistic change wrong, so its undo entry is dropped, the
+ * failure is shown in the status bar and a reload is requested. The reload,
+ * rather than a revert of the patch, is the one exception to patching the
+ * list in place: later mutations may have patched the same tasks.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ */
+void app_process_write_acks(AppState *app);
+
+/**
+ * @brief Clears the marks once a multi-task action on them was queued.
+ *
+ * The marks are kept aside until the write is acknowledged. If it fails they
+ * are put back, so the action can be retried without marking every task again.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ * @param[in] seq The sequence number of the queued write.
+ */
+void app_hold_marks(AppState *app, unsigned long seq);
+
+/**
+ * @brief Waits for every queued write and collects its acknowledgement.
+ *
+ * Must precede any read from the database, which would otherwise miss the
+ * changes still in the queue.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ */
+void app_sync_writes(AppState *app);
+
+/**
+ * @brief Merges the changes other Ordo instances committed to the database.
+ *
+ * Skipped while writes of this instance are in flight; they are merged on a
+ * later call. Requests a full reload if the merge fails.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ */
+void app_sync_external_changes(AppState *app);
+
+/**
+ * @brief Returns the ID of the selected task.
+ *
+ * @param[in] app Pointer to the AppState structure.
+ * @return The ID, or -1 if no task is selected, it is not in memory or the
+ * view was just switched.
+ */
+int app_selected_task_id(const AppState *app);
+
+/**
+ * @brief Selects a task of the current view by its ID.
+ *
+ * Used to keep the selection on the same task after the list was reloaded or
+ * merged changes moved it. The selection stays where it is if the task left
+ * the view.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ * @param[in] task_id The ID of the task, or -1 to leave the selection alone.
+ */
+void app_select_task(AppState *app, int task_id);
+
+/**
+ * @brief Runs a step of trash maintenance if one is due.
+ *
+ * Meant for idle ticks of the main loop. Each step purges a bounded batch of
+ * the trashed tasks the retention policy no longer keeps and releases a
+ * bounded number of free pages. Steps follow each other while there is work
+ * left, then the policy is checked again every few minutes.
+ *
+ * @param[in,out] app Pointer to the AppState structure.
+ */
+void app_run_maintenance(AppState *app);
+
+/**
+ * @brief Prints the active storage profile and the effective SQLite settings.
+ *
+ * Opens the database with the configured profile without starting the UI
+ * and checks that the view queries use their indexes. Used by
+ * `ordo --db-info`.
+ *
+ * @return The process exit status, non-zero if a query plan check failed.
+ */
+int app_print_db_info(void);
+
+/**
+ * @brief Compacts the database file without starting the UI.
+ *
+ * Databases created by older versions only return the space freed by trash
+ * purges to the file system after this one-time rewrite. Used by
+ * `ordo --compact`.
+ *
+ * @return The process exit status, non-zero on failure.
+ */
+int app_compact_db(void);
+
 #endif // APP_H
@@ -43,6 +43,11 @@ void set_default_config(AppConfig *config) {
   config->color_pair_task_pending = DEFAULT_COLOR_TASK_PENDING_PAIR;
   safe_snprintf(config->lang, sizeof(config->lang), "en");
   safe_snprintf(config->theme_name, sizeof(config->theme_name), "Ordo Classic");
+  config->windowed_loading = false;
+  safe_snprintf(config->storage_profile, sizeof(config->storage_profile),
+                "durable");
+  config->trash_retention_days = 0;
+  config->trash_max_tasks = 0;
 }
 
 // Function to create the configuration file with default values
@@ -55,7 +60,20 @@ static void create_default_config_file(const char *path) {
   fprintf(file, "# Default language (ISO 639-1 code)\n");
   fprintf(file, "lang = en\n\n");
   fprintf(file, "# Theme name\n");
-  fprintf(file, "theme = Ordo Classic\n");
+  fprintf(file, "theme = Ordo Classic\n\n");
+  fprintf(file, "# Task loading: 'full' keeps every task in memory, 'windowed'\n");
+  fprintf(file, "# only the visible page (for very large databases)\n");
+  fprintf(file, "load_mode = full\n\n");
+  fprintf(file, "# Storage profile: 'durable' (safest), 'balanced' (WAL),\n");
+  fprintf(file, "# 'fast' (WAL, no fsync) or 'memory-constrained'.\n");
+  fprintf(file, "# The WAL profiles need the database on a local filesystem.\n");
+  fprintf(file, "storage_profile = durable\n\n");
+  fprintf(file, "# Trash retention: tasks are deleted for good after this many\n");
+  fprintf(file, "# days in the trash, and the oldest ones once the trash holds\n");
+  fprintf(file, "# more than trash_max_tasks. 0 disables either limit; both\n");
+  fprintf(file, "# are off unless set here.\n");
+  fprintf(file, "trash_retention_days = 0\n");
+  fprintf(file, "trash_max_tasks = 0\n");
 
   fclose(file);
 }
@@ -111,6 +129,19 @@ void config_load(AppConfig *config) {
         } else if (strcmp(trimmed_key, "theme") == 0) {
           safe_snprintf(config->theme_name, sizeof(config->theme_name), "%s",
                    trimmed_value);
+        } else if (strcmp(trimmed_key, "load_mode") == 0) {
+          config->windowed_loading = strcmp(trimmed_value, "windowed") == 0;
+        } else if (strcmp(trimmed_key, "storage_profile") == 0) {
+          safe_snprintf(config->storage_profile,
+                        sizeof(config->storage_profile), "%s", trimmed_value);
+        } else if (strcmp(trimmed_key, "trash_retention_days") == 0) {
+          config->trash_retention_days = atoi(trimmed_value);
+          if (config->trash_retention_days < 0)
+            config->trash_retention_days = 0;
+        } else if (strcmp(trimmed_key, "trash_max_tasks") == 0) {
+          config->trash_max_tasks = atoi(trimmed_value);
+          if (config->trash_max_tasks < 0)
+            config->trash_max_tasks = 0;
         }
       }
       free(trimmed_key);
@@ -145,6 +176,11 @@ void config_save(const AppConfig *config) {
   fprintf(file, "# Ordo Configuration File\n");
   fprintf(file, "lang = %s\n", config->lang);
   fprintf(file, "theme = %s\n", config->theme_name);
+  fprintf(file, "load_mode = %s\n",
+          config->windowed_loading ? "windowed" : "full");
+  fprintf(file, "storage_profile = %s\n", config->storage_profile);
+  fprintf(file, "trash_retention_days = %d\n", config->trash_retention_days);
+  fprintf(file, "trash_max_tasks = %d\n", config->trash_max_tasks);
 
   fclose(file);
   free(config_dir);
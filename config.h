@@ -2,12 +2,24 @@
 #define CONFIG_H
 
 #include <ncurses.h>
+#include <stdbool.h>
 
 // Estrutura para armazenar as configuracoes de cores e outras preferencias.
 typedef struct {
   char lang[10];
   char theme_name[100];
 
+  // Carrega apenas a janela visivel de tarefas (load_mode = windowed)
+  bool windowed_loading;
+
+  // Perfil de armazenamento do SQLite (storage_profile = durable|balanced|...)
+  char storage_profile[24];
+
+  // Retencao da lixeira: dias ate a exclusao definitiva e numero maximo de
+  // tarefas (0 = sem limite)
+  int trash_retention_days;
+  int trash_max_tasks;
+
   // Pares de cores
   short color_pair_header;
   short color_pair_success;
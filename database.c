@@ -1,11 +1,108 @@
 #include "utils.h"
 #include "database.h"
+#include "perf_stats.h"
 #include "task_list.h"
 #include "utils.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+// Column list shared by every statement that yields a full task row.
+#define TASK_COLUMNS "id, descricao, concluida, is_deleted"
+
+// The current time as a Unix timestamp, as stored in `deleted_at`.
+#define SQL_NOW "CAST(strftime('%s', 'now') AS INTEGER)"
+
+// How long a statement waits for another connection to release its lock.
+#define DATABASE_BUSY_TIMEOUT_MS 5000
+
+// Searches whose terms match more rows than this in total are not ranked by
+// relevance.
+#define SEARCH_RANK_LIMIT 1000
+
+// Minimum number of rows kept in memory on each side of the visible page in
+// windowed mode.
+#define WINDOW_MIN_MARGIN 32
+
+// Connection settings of each storage profile, indexed by `StorageProfile`.
+// A negative cache size is in KiB rather than pages.
+typedef struct {
+  const char *name;
+  int page_size;
+  const char *journal_mode;
+  const char *synchronous;
+  sqlite3_int64 mmap_size;
+  int cache_size;
+  const char *temp_store;
+} StorageSettings;
+
+static const StorageSettings storage_profiles[STORAGE_PROFILE_COUNT] = {
+    [STORAGE_DURABLE] = {"durable", 4096, "DELETE", "FULL", 0, -2000,
+                         "DEFAULT"},
+    [STORAGE_BALANCED] = {"balanced", 4096, "WAL", "NORMAL", 64LL << 20, -8000,
+                          "MEMORY"},
+    [STORAGE_FAST] = {"fast", 8192, "WAL", "OFF", 256LL << 20, -32000,
+                      "MEMORY"},
+    [STORAGE_MEMORY_CONSTRAINED] = {"memory-constrained", 4096, "TRUNCATE",
+                                    "NORMAL", 0, -512, "FILE"},
+};
+
+const char *database_profile_name(StorageProfile profile) {
+  if (profile < 0 || profile >= STORAGE_PROFILE_COUNT)
+    profile = STORAGE_DEFAULT_PROFILE;
+  return storage_profiles[profile].name;
+}
+
+bool database_profile_from_name(const char *name, StorageProfile *profile) {
+  for (int i = 0; i < STORAGE_PROFILE_COUNT; ++i) {
+    if (strcmp(name, storage_profiles[i].name) == 0) {
+      *profile = (StorageProfile)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Applies the pragmas of a storage profile. The page size and auto-vacuum
+// mode must come first: they are ignored once the file has content or is in
+// WAL mode. Incremental vacuum lets the idle maintenance hand free pages back
+// to the file system a few at a time; older files keep reusing their free
+// pages until compacted with `database_compact`. A pragma that cannot be
+// applied (e.g. WAL on a VFS without shared memory) only produces a warning,
+// since the database stays usable with the previous setting.
+static void apply_storage_profile(sqlite3 *db, StorageProfile profile) {
+  const StorageSettings *s = &storage_profiles[profile];
+  char sql[256];
+  char *errMsg = 0;
+  safe_snprintf(sql, sizeof(sql),
+                "PRAGMA page_size = %d;"
+                "PRAGMA auto_vacuum = INCREMENTAL;",
+                s->page_size);
+  if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+    fprintf(stderr, "Warning: could not set the page layout of profile "
+                    "'%s': %s\n",
+            s->name, errMsg);
+    sqlite3_free(errMsg);
+    errMsg = 0;
+  }
+
+  safe_snprintf(sql, sizeof(sql),
+                "PRAGMA journal_mode = %s;"
+                "PRAGMA synchronous = %s;"
+                "PRAGMA mmap_size = %lld;"
+                "PRAGMA cache_size = %d;"
+                "PRAGMA temp_store = %s;",
+                s->journal_mode, s->synchronous, (long long)s->mmap_size,
+                s->cache_size, s->temp_store);
+  if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+    fprintf(stderr, "Warning: could not apply storage profile '%s': %s\n",
+            s->name, errMsg);
+    sqlite3_free(errMsg);
+  }
+}
 
 // Helper function to prepare a statement
 static OrdoResult prepare_stmt(sqlite3 *db, sqlite3_stmt **stmt,
@@ -18,14 +115,45 @@ static OrdoResult prepare_stmt(sqlite3 *db, sqlite3_stmt **stmt,
   return ORDO_OK;
 }
 
-static OrdoResult migrate_database_schema(Database *db) {
+// --- Schema Migrations ---
+// The schema version is kept in `PRAGMA user_version`: a database at version N
+// has had the first N entries of `migrations` applied. A step is one of:
+//   - `sql`: a schema change, committed atomically with the version bump;
+//   - `batch_sql`: a data rewrite taking the batch size as its only parameter.
+//     It is repeated, one transaction per batch, until it changes no rows, so
+//     it must only select rows that have not been rewritten yet. An interrupted
+//     rewrite resumes where it stopped on the next start;
+//   - `apply`: custom code, also committed with the version bump. With
+//     `standalone` set it runs outside any transaction instead, for code that
+//     commits on its own, and must be safe to repeat if interrupted before the
+//     version bump.
+// Append new steps at the end; never reorder or edit released ones.
+
+#define MIGRATION_BATCH_SIZE 5000
+
+static OrdoResult exec_sql(sqlite3 *db, const char *sql);
+static void read_pragma(sqlite3 *db, const char *pragma, char *out,
+                        size_t size);
+
+typedef struct {
+  const char *description;
+  const char *sql;
+  const char *batch_sql;
+  OrdoResult (*apply)(sqlite3 *db);
+  bool standalone;
+} Migration;
+
+static OrdoResult run_batches(sqlite3 *db, const Migration *step);
+
+// Databases created before versioning may lack the `is_deleted` column.
+static OrdoResult add_is_deleted_column(sqlite3 *db) {
   sqlite3_stmt *stmt;
   const char *sql = "PRAGMA table_info(tasks);";
   bool column_exists = false;
 
-  if (sqlite3_prepare_v2(db->db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
     fprintf(stderr, "Error preparing PRAGMA statement: %s\n",
-            sqlite3_errmsg(db->db));
+            sqlite3_errmsg(db));
     return ORDO_ERROR_DATABASE;
   }
 
@@ -42,7 +170,7 @@ static OrdoResult migrate_database_schema(Database *db) {
     char *errMsg = 0;
     const char *sql_alter =
         "ALTER TABLE tasks ADD COLUMN is_deleted INTEGER NOT NULL DEFAULT 0;";
-    if (sqlite3_exec(db->db, sql_alter, 0, 0, &errMsg) != SQLITE_OK) {
+    if (sqlite3_exec(db, sql_alter, 0, 0, &errMsg) != SQLITE_OK) {
       fprintf(stderr, "Error adding column to table: %s\n", errMsg);
       sqlite3_free(errMsg);
       return ORDO_ERROR_DATABASE;
@@ -51,9 +179,255 @@ static OrdoResult migrate_database_schema(Database *db) {
   return ORDO_OK;
 }
 
-OrdoResult database_init(sqlite3 *db_conn, Database *db) {
+// Whether the task `row` (`new` or `old`) is in the full-text index.
+#define FTS_INDEXED(row)                                                        \
+  "EXISTS (SELECT 1 FROM tasks_fts_docsize WHERE id = " row ".id)"
+
+// Full-text index of the descriptions, kept in sync by triggers. It is an
+// external-content table, so the text itself is only stored in `tasks`. The
+// prefix indexes keep as-you-type queries of one to three characters from
+// scanning every matching term. SQLite builds without FTS5 skip the step and
+// search with LIKE instead.
+//
+// The existing tasks are indexed by the next step, so the update and delete
+// triggers leave alone the rows not indexed yet (those without an entry in
+// the index's `docsize` table).
+static OrdoResult add_search_index(sqlite3 *db) {
+  char *errMsg = 0;
+  if (sqlite3_exec(db,
+                   "CREATE VIRTUAL TABLE IF NOT EXISTS tasks_fts USING fts5 "
+                   "(descricao, content = 'tasks', content_rowid = 'id', "
+                   "prefix = '1 2 3');",
+                   0, 0, &errMsg) != SQLITE_OK) {
+    fprintf(stderr, "Warning: full-text search is unavailable: %s\n", errMsg);
+    sqlite3_free(errMsg);
+    return ORDO_OK;
+  }
+  return exec_sql(
+      db,
+      "CREATE TRIGGER IF NOT EXISTS tasks_fts_insert AFTER INSERT ON tasks "
+      "BEGIN INSERT INTO tasks_fts (rowid, descricao) "
+      "VALUES (new.id, new.descricao); END;"
+      "CREATE TRIGGER IF NOT EXISTS tasks_fts_delete AFTER DELETE ON tasks "
+      "WHEN " FTS_INDEXED("old") " "
+      "BEGIN INSERT INTO tasks_fts (tasks_fts, rowid, descricao) "
+      "VALUES ('delete', old.id, old.descricao); END;"
+      "CREATE TRIGGER IF NOT EXISTS tasks_fts_update "
+      "AFTER UPDATE OF descricao ON tasks WHEN " FTS_INDEXED("old") " "
+      "BEGIN INSERT INTO tasks_fts (tasks_fts, rowid, descricao) "
+      "VALUES ('delete', old.id, old.descricao); "
+      "INSERT INTO tasks_fts (rowid, descricao) "
+      "VALUES (new.id, new.descricao); END;");
+}
+
+// Indexes the tasks that predate the full-text index, newest first, one
+// bounded transaction per batch so other instances can write in between.
+// Tasks inserted since then are indexed by the trigger and have higher IDs
+// than any older task, so the indexed rows are always those from the lowest
+// indexed ID up, and the next batch is the one just below it. Search works
+// meanwhile, without the older tasks; an interrupted fill resumes on the next
+// start.
+static OrdoResult fill_search_index(sqlite3 *db) {
+  sqlite3_stmt *stmt;
+  if (prepare_stmt(db, &stmt,
+                   "SELECT 1 FROM sqlite_master WHERE name = 'tasks_fts';") !=
+      ORDO_OK)
+    return ORDO_ERROR_DATABASE;
+  bool exists = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_finalize(stmt);
+  if (!exists)
+    return ORDO_OK; // No FTS5, see `add_search_index`
+
+  const Migration fill = {
+      "fill full-text search index", NULL,
+      "INSERT INTO tasks_fts (rowid, descricao) "
+      "SELECT id, descricao FROM tasks WHERE id < "
+      "(SELECT IFNULL(MIN(id), 9223372036854775807) FROM tasks_fts_docsize) "
+      "ORDER BY id DESC LIMIT ?1;",
+      NULL, false};
+  return run_batches(db, &fill);
+}
+
+// Trigger body recording a change to the task `row` (`new` or `old`).
+#define LOG_TASK_CHANGE(row)                                                    \
+  "INSERT INTO task_changes (task_id, rev) VALUES (" row ".id, "               \
+  "(SELECT IFNULL(MAX(rev), 0) + 1 FROM task_changes)) "                       \
+  "ON CONFLICT (task_id) DO UPDATE SET rev = excluded.rev;"
+
+static const Migration migrations[] = {
+    {"add is_deleted column", NULL, NULL, add_is_deleted_column, false},
+    // Partial covering indexes so that loading, counting and paging a view
+    // only reads the rows of that view. `is_deleted` is part of the key
+    // because the planner does not derive its value from the index predicate.
+    {"add partial indexes for active and deleted tasks",
+     "CREATE INDEX IF NOT EXISTS idx_tasks_active ON tasks "
+     "(id, concluida, is_deleted, descricao) WHERE is_deleted = 0;"
+     "CREATE INDEX IF NOT EXISTS idx_tasks_deleted ON tasks "
+     "(id, concluida, is_deleted, descricao) WHERE is_deleted = 1;",
+     NULL, NULL, false},
+    // Change log for other instances sharing the file: every write to `tasks`
+    // stamps the row's ID with the next value of a database-wide counter, so a
+    // reader can fetch only what changed since the counter value it last saw.
+    // A permanently deleted task keeps its entry, which is how readers learn
+    // about the deletion, until the entry is pruned.
+    {"add task change log",
+     "CREATE TABLE IF NOT EXISTS task_changes "
+     "(task_id INTEGER PRIMARY KEY, rev INTEGER NOT NULL);"
+     "CREATE INDEX IF NOT EXISTS idx_task_changes_rev ON task_changes (rev);"
+     "CREATE TRIGGER IF NOT EXISTS tasks_changed_insert AFTER INSERT ON tasks "
+     "BEGIN " LOG_TASK_CHANGE("new") " END;"
+     "CREATE TRIGGER IF NOT EXISTS tasks_changed_update AFTER UPDATE ON tasks "
+     "BEGIN " LOG_TASK_CHANGE("new") " END;"
+     "CREATE TRIGGER IF NOT EXISTS tasks_changed_delete AFTER DELETE ON tasks "
+     "BEGIN " LOG_TASK_CHANGE("old") " END;",
+     NULL, NULL, false},
+    {"add full-text search index", NULL, NULL, add_search_index, false},
+    {"fill full-text search index", NULL, NULL, fill_search_index, true},
+    // When each task entered the trash, for the retention policy. Tasks
+    // already in the trash count from the upgrade; the purge index finds the
+    // ones not stamped yet.
+    {"add deleted_at column",
+     "ALTER TABLE tasks ADD COLUMN deleted_at INTEGER;"
+     "CREATE INDEX IF NOT EXISTS idx_tasks_purge ON tasks "
+     "(deleted_at, id) WHERE is_deleted = 1;",
+     NULL, NULL, false},
+    {"stamp tasks already in the trash", NULL,
+     "UPDATE tasks SET deleted_at = " SQL_NOW " WHERE id IN "
+     "(SELECT id FROM tasks WHERE is_deleted = 1 AND deleted_at IS NULL "
+     "LIMIT ?1);",
+     NULL, false},
+    // The entries of deleted tasks are dropped from the change log once they
+    // are old enough, see `database_prune_changes`. Readers that last synced
+    // below the floor may have missed a deletion and reload instead.
+    {"add change log floor",
+     "CREATE TABLE IF NOT EXISTS task_changes_floor "
+     "(id INTEGER PRIMARY KEY CHECK (id = 0), rev INTEGER NOT NULL);"
+     "INSERT OR IGNORE INTO task_changes_floor (id, rev) VALUES (0, 0);",
+     NULL, NULL, false},
+};
+
+#define SCHEMA_VERSION ((int)(sizeof(migrations) / sizeof(migrations[0])))
+
+static OrdoResult exec_sql(sqlite3 *db, const char *sql) {
+  char *errMsg = 0;
+  if (sqlite3_exec(db, sql, 0, 0, &errMsg) != SQLITE_OK) {
+    fprintf(stderr, "Error executing '%s': %s\n", sql, errMsg);
+    sqlite3_free(errMsg);
+    return ORDO_ERROR_DATABASE;
+  }
+  return ORDO_OK;
+}
+
+static OrdoResult set_schema_version(sqlite3 *db, int version) {
+  char sql[64];
+  safe_snprintf(sql, sizeof(sql), "PRAGMA user_version = %d;", version);
+  return exec_sql(db, sql);
+}
+
+// Runs a batched data rewrite until a batch leaves every row untouched.
+static OrdoResult run_batches(sqlite3 *db, const Migration *step) {
+  sqlite3_stmt *stmt;
+  if (prepare_stmt(db, &stmt, step->batch_sql) != ORDO_OK)
+    return ORDO_ERROR_DATABASE;
+
+  OrdoResult result = ORDO_OK;
+  long long total = 0;
+  for (;;) {
+    if (exec_sql(db, "BEGIN IMMEDIATE;") != ORDO_OK) {
+      result = ORDO_ERROR_DATABASE;
+      break;
+    }
+    sqlite3_bind_int(stmt, 1, MIGRATION_BATCH_SIZE);
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+      fprintf(stderr, "Error migrating database (%s): %s\n",
+              step->description, sqlite3_errmsg(db));
+      exec_sql(db, "ROLLBACK;");
+      result = ORDO_ERROR_DATABASE;
+      break;
+    }
+    int changed = sqlite3_changes(db);
+    if (exec_sql(db, "COMMIT;") != ORDO_OK) {
+      exec_sql(db, "ROLLBACK;");
+      result = ORDO_ERROR_DATABASE;
+      break;
+    }
+    if (changed == 0)
+      break;
+    total += changed;
+    fprintf(stderr, "\rMigrating database (%s): %lld rows", step->description,
+            total);
+  }
+  if (total > 0)
+    fprintf(stderr, "\n");
+  sqlite3_finalize(stmt);
+  return result;
+}
+
+static OrdoResult migrate_database_schema(Database *db) {
+  sqlite3_stmt *stmt;
+  int version = 0;
+  if (prepare_stmt(db->db, &stmt, "PRAGMA user_version;") != ORDO_OK)
+    return ORDO_ERROR_DATABASE;
+  if (sqlite3_step(stmt) == SQLITE_ROW)
+    version = sqlite3_column_int(stmt, 0);
+  sqlite3_finalize(stmt);
+
+  if (version > SCHEMA_VERSION) {
+    fprintf(stderr,
+            "Database schema version %d is newer than this version of Ordo "
+            "supports (%d).\n",
+            version, SCHEMA_VERSION);
+    return ORDO_ERROR_DATABASE;
+  }
+
+  for (; version < SCHEMA_VERSION; ++version) {
+    const Migration *step = &migrations[version];
+
+    if (step->standalone) {
+      if (step->apply(db->db) != ORDO_OK ||
+          set_schema_version(db->db, version + 1) != ORDO_OK) {
+        fprintf(stderr, "Database migration %d (%s) failed.\n", version + 1,
+                step->description);
+        return ORDO_ERROR_DATABASE;
+      }
+      continue;
+    }
+
+    // Batches commit on their own; the version is only bumped once the
+    // rewrite is complete.
+    if (step->batch_sql) {
+      if (run_batches(db->db, step) != ORDO_OK ||
+          set_schema_version(db->db, version + 1) != ORDO_OK)
+        return ORDO_ERROR_DATABASE;
+      continue;
+    }
+
+    if (exec_sql(db->db, "BEGIN IMMEDIATE;") != ORDO_OK)
+      return ORDO_ERROR_DATABASE;
+    if ((step->sql && exec_sql(db->db, step->sql) != ORDO_OK) ||
+        (step->apply && step->apply(db->db) != ORDO_OK) ||
+        set_schema_version(db->db, version + 1) != ORDO_OK ||
+        exec_sql(db->db, "COMMIT;") != ORDO_OK) {
+      fprintf(stderr, "Database migration %d (%s) failed.\n", version + 1,
+              step->description);
+      exec_sql(db->db, "ROLLBACK;");
+      return ORDO_ERROR_DATABASE;
+    }
+  }
+  return ORDO_OK;
+}
+
+OrdoResult database_init(sqlite3 *db_conn, StorageProfile profile,
+                         Database *db) {
   *db = (Database){0};
   db->db = db_conn;
+  if (profile < 0 || profile >= STORAGE_PROFILE_COUNT)
+    profile = STORAGE_DEFAULT_PROFILE;
+  db->profile = profile;
+  apply_storage_profile(db->db, profile);
+  sqlite3_busy_timeout(db->db, DATABASE_BUSY_TIMEOUT_MS);
 
   char *errMsg = 0;
   const char *sql_create =
@@ -73,34 +447,160 @@ OrdoResult database_init(sqlite3 *db_conn, Database *db) {
   }
 
   // Prepare all statements. If any fail, clean up and return an error.
+  // Mutations return the affected row so the writer can patch the UI's list.
   if (prepare_stmt(db->db, &db->add_task_stmt,
-                   "INSERT INTO tasks (descricao, concluida) VALUES (?, 0);") != ORDO_OK ||
+                   "INSERT INTO tasks (descricao, concluida) VALUES (?, 0) "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->remove_task_stmt,
-                   "UPDATE tasks SET is_deleted = 1 WHERE id = ?;") != ORDO_OK ||
+                   "UPDATE tasks SET is_deleted = 1, deleted_at = " SQL_NOW " "
+                   "WHERE id = ? AND is_deleted = 0 "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->toggle_task_status_stmt,
-                   "UPDATE tasks SET concluida = ? WHERE id = ?;") != ORDO_OK ||
+                   "UPDATE tasks SET concluida = ? WHERE id = ? "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->update_task_description_stmt,
-                   "UPDATE tasks SET descricao = ? WHERE id = ?;") != ORDO_OK ||
+                   "UPDATE tasks SET descricao = ? WHERE id = ? "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->load_tasks_stmt,
-                   "SELECT id, descricao, concluida FROM tasks "
+                   "SELECT " TASK_COLUMNS " FROM tasks "
                    "WHERE is_deleted = 0 ORDER BY id;") != ORDO_OK ||
       prepare_stmt(db->db, &db->restore_task_stmt,
-                   "UPDATE tasks SET is_deleted = 0 WHERE id = ?;") != ORDO_OK ||
+                   "UPDATE tasks SET is_deleted = 0, deleted_at = NULL "
+                   "WHERE id = ? AND is_deleted = 1 "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->perm_delete_task_stmt,
-                   "DELETE FROM tasks WHERE id = ?;") != ORDO_OK ||
+                   "DELETE FROM tasks WHERE id = ? "
+                   "RETURNING " TASK_COLUMNS ";") != ORDO_OK ||
       prepare_stmt(db->db, &db->load_deleted_tasks_stmt,
-                   "SELECT id, descricao, concluida FROM tasks "
-                   "WHERE is_deleted = 1 ORDER BY id;") != ORDO_OK) {
+                   "SELECT " TASK_COLUMNS " FROM tasks "
+                   "WHERE is_deleted = 1 ORDER BY id;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->begin_stmt, "BEGIN IMMEDIATE;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->commit_stmt, "COMMIT;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->rollback_stmt, "ROLLBACK;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->data_version_stmt, "PRAGMA data_version;") !=
+          ORDO_OK ||
+      prepare_stmt(db->db, &db->change_rev_stmt,
+                   "SELECT IFNULL(MAX(rev), 0) FROM task_changes;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->change_floor_stmt,
+                   "SELECT rev FROM task_changes_floor;") != ORDO_OK ||
+      prepare_stmt(db->db, &db->changes_since_stmt,
+                   "SELECT t.id, t.descricao, t.concluida, t.is_deleted, "
+                   "c.task_id, c.rev FROM task_changes c "
+                   "LEFT JOIN tasks t ON t.id = c.task_id "
+                   "WHERE c.rev > ? ORDER BY c.rev;") != ORDO_OK) {
     database_close(db); // Ensures cleanup in case of failure
     return ORDO_ERROR_DATABASE;
   }
 
+  // Retention: delete trashed tasks past their age, oldest first, then the
+  // oldest beyond the size limit.
+  if (prepare_stmt(db->db, &db->purge_expired_stmt,
+                   "DELETE FROM tasks WHERE id IN (SELECT id FROM tasks "
+                   "WHERE is_deleted = 1 AND deleted_at < ?1 "
+                   "ORDER BY deleted_at, id LIMIT ?2);") != ORDO_OK ||
+      prepare_stmt(db->db, &db->purge_excess_stmt,
+                   "DELETE FROM tasks WHERE id IN (SELECT id FROM tasks "
+                   "WHERE is_deleted = 1 ORDER BY deleted_at, id "
+                   "LIMIT MIN(?2, MAX(0, (SELECT COUNT(*) FROM tasks "
+                   "WHERE is_deleted = 1) - ?1)));") != ORDO_OK ||
+      prepare_stmt(db->db, &db->freelist_count_stmt,
+                   "PRAGMA freelist_count;") != ORDO_OK) {
+    database_close(db);
+    return ORDO_ERROR_DATABASE;
+  }
+
+  // Change log pruning: the last and the number of the next `limit` entries
+  // above the floor that are older than the `keep` latest changes, then the
+  // deleted tasks' entries up to it.
+  if (prepare_stmt(db->db, &db->prune_range_stmt,
+                   "SELECT MAX(rev), COUNT(*) FROM (SELECT rev FROM task_changes "
+                   "WHERE rev > (SELECT rev FROM task_changes_floor) "
+                   "AND rev <= (SELECT MAX(rev) FROM task_changes) - ?1 "
+                   "ORDER BY rev LIMIT ?2);") != ORDO_OK ||
+      prepare_stmt(db->db, &db->prune_changes_stmt,
+                   "DELETE FROM task_changes "
+                   "WHERE rev > (SELECT rev FROM task_changes_floor) "
+                   "AND rev <= ?1 AND task_id NOT IN (SELECT id FROM tasks);") !=
+          ORDO_OK ||
+      prepare_stmt(db->db, &db->raise_floor_stmt,
+                   "UPDATE task_changes_floor SET rev = ?1;") != ORDO_OK) {
+    database_close(db);
+    return ORDO_ERROR_DATABASE;
+  }
+
+  // Rank matches with BM25 when the full-text index exists.
+  db->full_text_search =
+      sqlite3_prepare_v2(
+          db->db,
+          "SELECT t.id, t.descricao, t.concluida, t.is_deleted "
+          "FROM tasks_fts JOIN tasks t ON t.id = tasks_fts.rowid "
+          "WHERE tasks_fts MATCH ?1 AND t.is_deleted = ?2 "
+          "ORDER BY tasks_fts.rank LIMIT ?3;",
+          -1, &db->search_stmt, NULL) == SQLITE_OK;
+  if (db->full_text_search &&
+      (prepare_stmt(db->db, &db->search_probe_stmt,
+                    "SELECT COUNT(*) FROM (SELECT 1 FROM tasks_fts "
+                    "WHERE tasks_fts MATCH ?1 LIMIT ?2);") != ORDO_OK ||
+       prepare_stmt(db->db, &db->search_unranked_stmt,
+                    "SELECT t.id, t.descricao, t.concluida, t.is_deleted "
+                    "FROM tasks_fts JOIN tasks t ON t.id = tasks_fts.rowid "
+                    "WHERE tasks_fts MATCH ?1 AND t.is_deleted = ?2 "
+                    "LIMIT ?3;") != ORDO_OK)) {
+    database_close(db);
+    return ORDO_ERROR_DATABASE;
+  }
+  if (!db->full_text_search &&
+      prepare_stmt(db->db, &db->search_stmt,
+                   "SELECT " TASK_COLUMNS " FROM tasks "
+                   "WHERE descricao LIKE ?1 ESCAPE '\\' AND is_deleted = ?2 "
+                   "ORDER BY id LIMIT ?3;") != ORDO_OK) {
+    database_close(db);
+    return ORDO_ERROR_DATABASE;
+  }
+
+  // Windowed loading statements, one set per value of `is_deleted`.
+  for (int scope = 0; scope <= 1; ++scope) {
+    char sql[256];
+    safe_snprintf(sql, sizeof(sql),
+                  "SELECT COUNT(*) FROM tasks WHERE is_deleted = %d;", scope);
+    if (prepare_stmt(db->db, &db->count_tasks_stmt[scope], sql) != ORDO_OK) {
+      database_close(db);
+      return ORDO_ERROR_DATABASE;
+    }
+    safe_snprintf(sql, sizeof(sql),
+                  "SELECT " TASK_COLUMNS " FROM tasks WHERE is_deleted = %d "
+                  "AND id > ? ORDER BY id LIMIT ? OFFSET ?;",
+                  scope);
+    if (prepare_stmt(db->db, &db->page_forward_stmt[scope], sql) != ORDO_OK) {
+      database_close(db);
+      return ORDO_ERROR_DATABASE;
+    }
+    safe_snprintf(sql, sizeof(sql),
+                  "SELECT " TASK_COLUMNS " FROM tasks WHERE is_deleted = %d "
+                  "AND id < ? ORDER BY id DESC LIMIT ? OFFSET ?;",
+                  scope);
+    if (prepare_stmt(db->db, &db->page_backward_stmt[scope], sql) != ORDO_OK) {
+      database_close(db);
+      return ORDO_ERROR_DATABASE;
+    }
+    safe_snprintf(sql, sizeof(sql),
+                  "SELECT COUNT(*) FROM tasks WHERE is_deleted = %d "
+                  "AND id < ?;",
+                  scope);
+    if (prepare_stmt(db->db, &db->count_before_stmt[scope], sql) != ORDO_OK) {
+      database_close(db);
+      return ORDO_ERROR_DATABASE;
+    }
+  }
+
+  task_list_init(&db->returned);
   return ORDO_OK;
 }
 
 void database_close(Database *db) {
   if (!db)
     return;
+  task_list_free(&db->returned);
   sqlite3_finalize(db->add_task_stmt);
   sqlite3_finalize(db->remove_task_stmt);
   sqlite3_finalize(db->toggle_task_status_stmt);
@@ -109,27 +609,95 @@ void database_close(Database *db) {
   sqlite3_finalize(db->restore_task_stmt);
   sqlite3_finalize(db->perm_delete_task_stmt);
   sqlite3_finalize(db->load_deleted_tasks_stmt);
+  sqlite3_finalize(db->begin_stmt);
+  sqlite3_finalize(db->commit_stmt);
+  sqlite3_finalize(db->rollback_stmt);
+  sqlite3_finalize(db->data_version_stmt);
+  sqlite3_finalize(db->change_rev_stmt);
+  sqlite3_finalize(db->changes_since_stmt);
+  sqlite3_finalize(db->change_floor_stmt);
+  sqlite3_finalize(db->search_stmt);
+  sqlite3_finalize(db->purge_expired_stmt);
+  sqlite3_finalize(db->purge_excess_stmt);
+  sqlite3_finalize(db->freelist_count_stmt);
+  sqlite3_finalize(db->prune_range_stmt);
+  sqlite3_finalize(db->prune_changes_stmt);
+  sqlite3_finalize(db->raise_floor_stmt);
+  sqlite3_finalize(db->search_probe_stmt);
+  sqlite3_finalize(db->search_unranked_stmt);
+  for (int scope = 0; scope <= 1; ++scope) {
+    sqlite3_finalize(db->count_tasks_stmt[scope]);
+    sqlite3_finalize(db->page_forward_stmt[scope]);
+    sqlite3_finalize(db->page_backward_stmt[scope]);
+    sqlite3_finalize(db->count_before_stmt[scope]);
+  }
 
   if (db->db) {
     sqlite3_close(db->db);
   }
 }
 
+// Reads a single-valued pragma as text into `out`.
+static void read_pragma(sqlite3 *db, const char *pragma, char *out,
+                        size_t size) {
+  char sql[64];
+  sqlite3_stmt *stmt;
+  safe_snprintf(sql, sizeof(sql), "PRAGMA %s;", pragma);
+  safe_snprintf(out, size, "?");
+  if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK)
+    return;
+  if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_text(stmt, 0))
+    safe_snprintf(out, size, "%s", (const char *)sqlite3_column_text(stmt, 0));
+  sqlite3_finalize(stmt);
+}
+
+void database_print_storage_info(Database *db, FILE *out) {
+  static const char *const pragmas[] = {"page_size", "journal_mode",
+                                        "synchronous", "mmap_size",
+                                        "cache_size", "temp_store",
+                                        "auto_vacuum", "freelist_count"};
+  static const char *const sync_names[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+  static const char *const temp_names[] = {"DEFAULT", "FILE", "MEMORY"};
+  static const char *const vacuum_names[] = {"NONE", "FULL", "INCREMENTAL"};
+
+  fprintf(out, "Storage profile: %s\n", database_profile_name(db->profile));
+  for (size_t i = 0; i < sizeof(pragmas) / sizeof(pragmas[0]); ++i) {
+    char value[64];
+    read_pragma(db->db, pragmas[i], value, sizeof(value));
+    const char *label = NULL;
+    int n = atoi(value);
+    if (strcmp(pragmas[i], "synchronous") == 0 && n >= 0 && n <= 3)
+      label = sync_names[n];
+    else if (strcmp(pragmas[i], "temp_store") == 0 && n >= 0 && n <= 2)
+      label = temp_names[n];
+    else if (strcmp(pragmas[i], "auto_vacuum") == 0 && n >= 0 && n <= 2)
+      label = vacuum_names[n];
+    if (label)
+      fprintf(out, "  %-14s %s (%s)\n", pragmas[i], value, label);
+    else
+      fprintf(out, "  %-14s %s\n", pragmas[i], value);
+  }
+}
+
+// Reads a row laid out as `TASK_COLUMNS` into a task structure. The
+// description is not copied: it is only valid until the statement is stepped
+// or reset, so the row must be added to a list before that.
+static void read_task_row(sqlite3_stmt *stmt, Task *task) {
+  task->id = sqlite3_column_int(stmt, 0);
+  const unsigned char *desc = sqlite3_column_text(stmt, 1);
+  task->descricao = desc ? (const char *)desc : "";
+  task->concluida = sqlite3_column_int(stmt, 2);
+  task->is_deleted = sqlite3_column_int(stmt, 3);
+}
+
 static OrdoResult load_tasks_generic(sqlite3_stmt *select_stmt,
-                                     TaskList *list) {
+                                     int deleted_scope, TaskList *list) {
   task_list_clear(list); // Clear the list before loading new tasks
+  list->deleted_scope = deleted_scope;
 
   while (sqlite3_step(select_stmt) == SQLITE_ROW) {
     Task task;
-    task.id = sqlite3_column_int(select_stmt, 0);
-    const unsigned char *desc = sqlite3_column_text(select_stmt, 1);
-    // Safely copy the description to the task structure.
-    if (desc) {
-      safe_snprintf(task.descricao, MAX_DESCRICAO, "%s", (const char *)desc);
-    } else {
-      task.descricao[0] = '\0';
-    }
-    task.concluida = sqlite3_column_int(select_stmt, 2);
+    read_task_row(select_stmt, &task);
 
     if (!task_list_add(list, &task)) {
       sqlite3_reset(select_stmt);
@@ -138,104 +706,603 @@ static OrdoResult load_tasks_generic(sqlite3_stmt *select_stmt,
   }
 
   sqlite3_reset(select_stmt);
+  // Views are not updated row by row during a load; index the active one now.
+  if (!task_list_set_view(list, list->view)) {
+    return ORDO_ERROR_GENERIC;
+  }
+  return ORDO_OK;
+}
+
+// Counts the tasks of a view and starts an empty window at its top.
+static OrdoResult reset_window(Database *db, int deleted_scope,
+                               TaskList *list) {
+  sqlite3_stmt *stmt = db->count_tasks_stmt[deleted_scope];
+  task_list_clear(list);
+  list->deleted_scope = deleted_scope;
+
+  if (sqlite3_step(stmt) != SQLITE_ROW) {
+    sqlite3_reset(stmt);
+    return ORDO_ERROR_DATABASE;
+  }
+  list->total_count = sqlite3_column_int(stmt, 0);
+  sqlite3_reset(stmt);
   return ORDO_OK;
 }
 
+// Runs a statement that yields a single integer.
+static bool read_int64(sqlite3_stmt *stmt, sqlite3_int64 *value) {
+  bool ok = sqlite3_step(stmt) == SQLITE_ROW;
+  if (ok)
+    *value = sqlite3_column_int64(stmt, 0);
+  sqlite3_reset(stmt);
+  return ok;
+}
+
+// Records the change counter before a view is read, so that
+// `database_sync_changes` picks up every change the read may have missed.
+// Changes the read did see are merely applied twice.
+static void mark_synced(Database *db) {
+  sqlite3_int64 value;
+  if (read_int64(db->data_version_stmt, &value))
+    db->data_version = value;
+  if (read_int64(db->change_rev_stmt, &value))
+    db->synced_rev = value;
+}
+
 OrdoResult database_load_tasks(Database *db, TaskList *list) {
-  return load_tasks_generic(db->load_tasks_stmt, list);
+  uint64_t start = perf_now();
+  mark_synced(db);
+  OrdoResult result = list->windowed
+                          ? reset_window(db, 0, list)
+                          : load_tasks_generic(db->load_tasks_stmt, 0, list);
+  perf_db_record(PERF_DB_LOAD, start, list->count);
+  return result;
 }
 
 OrdoResult database_load_deleted_tasks(Database *db, TaskList *list) {
-  return load_tasks_generic(db->load_deleted_tasks_stmt, list);
+  uint64_t start = perf_now();
+  mark_synced(db);
+  OrdoResult result =
+      list->windowed ? reset_window(db, 1, list)
+                     : load_tasks_generic(db->load_deleted_tasks_stmt, 1, list);
+  perf_db_record(PERF_DB_TRASH, start, list->count);
+  return result;
 }
 
-OrdoResult database_add_task(Database *db, const char *description,
-                             int *new_task_id) {
-  sqlite3_stmt *stmt = db->add_task_stmt;
-  sqlite3_bind_text(stmt, 1, description, -1, SQLITE_TRANSIENT);
+// A keyset starting point for a page: rows strictly after (or before) the
+// anchor ID, skipping `skip` of them. The skipped rows are still read, so
+// `skip` is what a page costs beyond its own rows.
+typedef struct {
+  sqlite3_int64 anchor_id;
+  bool forward;
+  int skip;
+} PageAnchor;
 
-  if (sqlite3_step(stmt) != SQLITE_DONE) {
-    sqlite3_reset(stmt);
-    return ORDO_ERROR_DATABASE;
+// Keeps the cheaper of two anchors (the one that skips fewer rows).
+static void consider_anchor(PageAnchor *best, sqlite3_int64 anchor_id,
+                            bool forward, int skip) {
+  if (skip >= 0 && (best->skip < 0 || skip < best->skip)) {
+    *best = (PageAnchor){anchor_id, forward, skip};
+  }
+}
+
+OrdoResult database_load_window(Database *db, TaskList *list, int first,
+                                int visible) {
+  if (!list->windowed || task_list_covers(list, first, visible)) {
+    return ORDO_OK;
+  }
+  uint64_t perf_start = perf_now();
+
+  // Fetch the visible page plus a margin on each side.
+  int margin = visible > WINDOW_MIN_MARGIN ? visible : WINDOW_MIN_MARGIN;
+  int length = visible + 2 * margin;
+  int start = first - margin;
+  if (start + length > list->total_count) {
+    start = list->total_count - length;
+  }
+  if (start < 0) {
+    start = 0;
+  }
+  int end = start + length;
+  if (end > list->total_count) {
+    end = list->total_count;
+  }
+
+  // Anchor on whichever known row is closest: the ends of the view or the
+  // edges of the current window.
+  PageAnchor anchor = {0, true, -1};
+  consider_anchor(&anchor, INT64_MIN, true, start);
+  consider_anchor(&anchor, INT64_MAX, false, list->total_count - end);
+  int window_end = list->window_start + list->count;
+  if (list->count > 0) {
+    if (start > list->window_start && start <= window_end) {
+      consider_anchor(&anchor, task_list_at(list, start - 1)->id, true, 0);
+    } else if (start > window_end) {
+      consider_anchor(&anchor, task_list_at(list, window_end - 1)->id, true,
+                      start - window_end);
+    }
+    if (end >= list->window_start && end < window_end) {
+      consider_anchor(&anchor, task_list_at(list, end)->id, false, 0);
+    } else if (end < list->window_start) {
+      consider_anchor(&anchor, task_list_at(list, list->window_start)->id,
+                      false, list->window_start - end);
+    }
   }
 
-  *new_task_id = (int)sqlite3_last_insert_rowid(db->db);
+  sqlite3_stmt *stmt = anchor.forward
+                           ? db->page_forward_stmt[list->deleted_scope]
+                           : db->page_backward_stmt[list->deleted_scope];
+  sqlite3_bind_int64(stmt, 1, anchor.anchor_id);
+  sqlite3_bind_int(stmt, 2, end - start);
+  sqlite3_bind_int(stmt, 3, anchor.skip);
+
+  int total_count = list->total_count;
+  task_list_clear(list);
+  list->total_count = total_count;
+  list->window_start = start;
+
+  OrdoResult result = ORDO_OK;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    Task task;
+    read_task_row(stmt, &task);
+    if (!task_list_add(list, &task)) {
+      result = ORDO_ERROR_GENERIC;
+      break;
+    }
+  }
   sqlite3_reset(stmt);
-  return ORDO_OK;
+
+  if (result != ORDO_OK) {
+    // A partial page does not hold the positions it claims, and a backward
+    // one is not even in order. Drop it so the next frame loads it again.
+    task_list_clear(list);
+    list->total_count = total_count;
+  } else if (!anchor.forward) {
+    // Backward pages arrive in descending ID order.
+    task_list_reverse(list);
+  }
+  perf_db_record(PERF_DB_WINDOW, perf_start, list->count);
+  return result;
 }
 
-static OrdoResult execute_simple_update(Database *db, sqlite3_stmt *stmt,
-                                        int task_id) {
-  sqlite3_bind_int(stmt, 1, task_id);
+// --- Change Detection ---
 
-  if (sqlite3_step(stmt) != SQLITE_DONE) {
-    sqlite3_reset(stmt);
+// Whether a windowed list can place a row it does not hold: only rows between
+// its first and last cached row are known to be absent from the view.
+static bool within_window(const TaskList *list, int task_id) {
+  int window_end = list->window_start + list->count;
+  return !list->windowed ||
+         (list->count > 0 &&
+          task_id > task_list_at(list, list->window_start)->id &&
+          task_id < task_list_at(list, window_end - 1)->id);
+}
+
+// Re-reads the view size and the window position after changes outside the
+// window.
+static OrdoResult recount_window(Database *db, TaskList *list) {
+  sqlite3_int64 total = 0;
+  sqlite3_int64 before = 0;
+  sqlite3_stmt *stmt = db->count_before_stmt[list->deleted_scope];
+  if (!read_int64(db->count_tasks_stmt[list->deleted_scope], &total))
     return ORDO_ERROR_DATABASE;
+  if (list->count > 0) {
+    sqlite3_bind_int(stmt, 1, task_list_at(list, list->window_start)->id);
+    if (!read_int64(stmt, &before))
+      return ORDO_ERROR_DATABASE;
   }
+  list->total_count = (int)total;
+  list->window_start = (int)before;
+  return ORDO_OK;
+}
 
-  if (sqlite3_changes(db->db) == 0) {
-    sqlite3_reset(stmt);
-    return ORDO_ERROR_TASK_NOT_FOUND;
-  }
+static OrdoResult merge_changes(Database *db, TaskList *list, int *rows) {
+  sqlite3_stmt *stmt = db->changes_since_stmt;
+  sqlite3_bind_int64(stmt, 1, db->synced_rev);
+
+  OrdoResult result = ORDO_OK;
+  bool recount = false;
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    (*rows)++;
+    int task_id = sqlite3_column_int(stmt, 4);
+    bool cached = task_list_find(list, task_id) >= 0;
+    db->synced_rev = sqlite3_column_int64(stmt, 5);
 
+    if (!cached && !within_window(list, task_id)) {
+      recount = true; // Its effect on the view is unknown
+      continue;
+    }
+    if (sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+      if (cached)
+        task_list_forget(list, task_id, list->deleted_scope);
+      continue;
+    }
+
+    Task row;
+    read_task_row(stmt, &row);
+    if (!task_list_apply(list, &row,
+                         cached ? list->deleted_scope : TASK_LIST_NEW_ROW)) {
+      result = ORDO_ERROR_GENERIC;
+      break;
+    }
+  }
+  if (result == ORDO_OK && rc != SQLITE_DONE)
+    result = ORDO_ERROR_DATABASE;
   sqlite3_reset(stmt);
-  return ORDO_OK;
+
+  if (result == ORDO_OK && recount)
+    result = recount_window(db, list);
+  return result;
+}
+
+OrdoResult database_sync_changes(Database *db, TaskList *list) {
+  sqlite3_int64 version;
+  if (!read_int64(db->data_version_stmt, &version))
+    return ORDO_ERROR_DATABASE;
+  if (version == db->data_version)
+    return ORDO_OK; // No other connection has committed since the last check
+  db->data_version = version;
+
+  // Read the changes and the counts from a single snapshot.
+  uint64_t start = perf_now();
+  if (exec_sql(db->db, "BEGIN;") != ORDO_OK)
+    return ORDO_ERROR_DATABASE;
+  int rows = 0;
+  sqlite3_int64 floor = 0;
+  OrdoResult result = ORDO_OK;
+  if (!read_int64(db->change_floor_stmt, &floor))
+    result = ORDO_ERROR_DATABASE;
+  else if (db->synced_rev < floor)
+    result = ORDO_ERROR_GENERIC; // Changes since the last sync were pruned
+  else
+    result = merge_changes(db, list, &rows);
+  exec_sql(db->db, "COMMIT;");
+  perf_db_record(PERF_DB_SYNC, start, rows);
+  return result;
+}
+
+// --- Search ---
+
+// Turns the text typed by the user into an FTS5 query: every word becomes a
+// quoted prefix term, so operators and punctuation are taken literally and the
+// last word matches while it is still being typed. Must be freed.
+static char *build_match_query(const char *text) {
+  // A lone quote, the worst case, becomes `""""*`.
+  char *query = ordo_malloc(strlen(text) * 5 + 1);
+  if (!query)
+    return NULL;
+
+  size_t out = 0;
+  const char *p = text;
+  while (*p) {
+    while (*p == ' ' || *p == '\t')
+      p++;
+    if (!*p)
+      break;
+    if (out > 0)
+      query[out++] = ' ';
+    query[out++] = '"';
+    for (; *p && *p != ' ' && *p != '\t'; p++) {
+      if (*p == '"')
+        query[out++] = '"';
+      query[out++] = *p;
+    }
+    query[out++] = '"';
+    query[out++] = '*';
+  }
+  query[out] = '\0';
+  return query;
 }
 
-OrdoResult database_remove_task(Database *db, int task_id) {
-  return execute_simple_update(db, db->remove_task_stmt, task_id);
+// Turns the text typed by the user into a LIKE pattern matching it anywhere.
+// Must be freed.
+static char *build_like_pattern(const char *text) {
+  char *pattern = ordo_malloc(strlen(text) * 2 + 3);
+  if (!pattern)
+    return NULL;
+
+  size_t out = 0;
+  pattern[out++] = '%';
+  for (const char *p = text; *p; p++) {
+    if (*p == '%' || *p == '_' || *p == '\\')
+      pattern[out++] = '\\';
+    pattern[out++] = *p;
+  }
+  pattern[out++] = '%';
+  pattern[out] = '\0';
+  return pattern;
 }
 
-OrdoResult database_restore_task(Database *db, int task_id) {
-  return execute_simple_update(db, db->restore_task_stmt, task_id);
+// BM25 weighs each term by the number of descriptions containing it, so
+// ranking reads every match of every term. Queries whose terms match more rows
+// than can be ranked quickly, such as the first letter or two of a common word,
+// are listed by ID instead. `query` is built by `build_match_query`, whose
+// terms never contain spaces.
+static bool can_rank(Database *db, const char *query, bool *rank) {
+  sqlite3_stmt *stmt = db->search_probe_stmt;
+  sqlite3_int64 matches = 0;
+  const char *term = query;
+  while (*term && matches <= SEARCH_RANK_LIMIT) {
+    size_t length = strcspn(term, " ");
+    sqlite3_int64 count;
+    sqlite3_bind_text(stmt, 1, term, (int)length, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, SEARCH_RANK_LIMIT - matches + 1);
+    bool ok = read_int64(stmt, &count);
+    sqlite3_clear_bindings(stmt);
+    if (!ok)
+      return false;
+    matches += count;
+    term += length;
+    if (*term == ' ')
+      term++;
+  }
+  *rank = matches <= SEARCH_RANK_LIMIT;
+  return true;
 }
 
-OrdoResult database_permanently_delete_task(Database *db, int task_id) {
-  return execute_simple_update(db, db->perm_delete_task_stmt, task_id);
+OrdoResult database_search_tasks(Database *db, const char *text,
+                                 int deleted_scope, int limit,
+                                 TaskList *results) {
+  auto_free_ptr char *query = db->full_text_search ? build_match_query(text)
+                                                   : build_like_pattern(text);
+  if (!query)
+    return ORDO_ERROR_GENERIC;
+  if (query[0] == '\0') {
+    task_list_clear(results); // Nothing typed yet
+    results->deleted_scope = deleted_scope;
+    return ORDO_OK;
+  }
+
+  uint64_t start = perf_now();
+  sqlite3_stmt *stmt = db->search_stmt;
+  if (db->full_text_search) {
+    bool rank;
+    if (!can_rank(db, query, &rank))
+      return ORDO_ERROR_DATABASE;
+    if (!rank)
+      stmt = db->search_unranked_stmt;
+  }
+
+  sqlite3_bind_text(stmt, 1, query, -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, deleted_scope);
+  sqlite3_bind_int(stmt, 3, limit);
+  OrdoResult result = load_tasks_generic(stmt, deleted_scope, results);
+  sqlite3_clear_bindings(stmt);
+  perf_db_record(PERF_DB_SEARCH, start, results->count);
+  return result;
 }
 
-OrdoResult database_toggle_task_status(Database *db, int task_id,
-                                       int current_status) {
-  sqlite3_stmt *stmt = db->toggle_task_status_stmt;
-  int new_status = !current_status;
+OrdoResult database_find_position(Database *db, const TaskList *list,
+                                  int task_id, int *position) {
+  int index = task_list_find(list, task_id);
+  if (index >= 0 || !list->windowed) {
+    *position = index >= 0 ? task_list_position(list, index) : -1;
+    return *position >= 0 ? ORDO_OK : ORDO_ERROR_TASK_NOT_FOUND;
+  }
 
-  sqlite3_bind_int(stmt, 1, new_status);
-  sqlite3_bind_int(stmt, 2, task_id);
+  sqlite3_int64 before;
+  sqlite3_stmt *stmt = db->count_before_stmt[list->deleted_scope];
+  sqlite3_bind_int(stmt, 1, task_id);
+  if (!read_int64(stmt, &before))
+    return ORDO_ERROR_DATABASE;
+  *position = (int)before;
+  return ORDO_OK;
+}
 
-  if (sqlite3_step(stmt) != SQLITE_DONE) {
-    sqlite3_reset(stmt);
+// Steps a bound mutation and reads the row produced by its RETURNING clause.
+// The row is appended to `db->returned`, which keeps its description until
+// the next mutation clears the list.
+static OrdoResult step_returning(Database *db, sqlite3_stmt *stmt,
+                                 Task *row) {
+  int rc = sqlite3_step(stmt);
+  bool found = (rc == SQLITE_ROW);
+  if (found) {
+    read_task_row(stmt, row);
+    if (!task_list_add(&db->returned, row)) {
+      sqlite3_reset(stmt);
+      return ORDO_ERROR_GENERIC;
+    }
+    *row = db->returned.tasks[db->returned.count - 1];
+    rc = sqlite3_step(stmt);
+  }
+  sqlite3_reset(stmt);
+
+  if (rc != SQLITE_DONE) {
     return ORDO_ERROR_DATABASE;
   }
+  return found ? ORDO_OK : ORDO_ERROR_TASK_NOT_FOUND;
+}
+
+OrdoResult database_write_row(Database *db, DatabaseWrite op, int task_id,
+                              int status, const char *description, Task *row) {
+  sqlite3_stmt *stmt = NULL;
+  switch (op) {
+  case DB_WRITE_ADD:
+    stmt = db->add_task_stmt;
+    sqlite3_bind_text(stmt, 1, description, -1, SQLITE_TRANSIENT);
+    break;
+  case DB_WRITE_REMOVE:
+    stmt = db->remove_task_stmt;
+    sqlite3_bind_int(stmt, 1, task_id);
+    break;
+  case DB_WRITE_RESTORE:
+    stmt = db->restore_task_stmt;
+    sqlite3_bind_int(stmt, 1, task_id);
+    break;
+  case DB_WRITE_PERM_DELETE:
+    stmt = db->perm_delete_task_stmt;
+    sqlite3_bind_int(stmt, 1, task_id);
+    break;
+  case DB_WRITE_TOGGLE:
+    stmt = db->toggle_task_status_stmt;
+    sqlite3_bind_int(stmt, 1, status);
+    sqlite3_bind_int(stmt, 2, task_id);
+    break;
+  case DB_WRITE_EDIT:
+    stmt = db->update_task_description_stmt;
+    sqlite3_bind_text(stmt, 1, description, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, task_id);
+    break;
+  case DB_WRITE_PURGE:
+    break; // Not a row mutation, see `database_purge_trash`
+  }
+  if (!stmt) {
+    return ORDO_ERROR_INVALID_INPUT;
+  }
 
-  if (sqlite3_changes(db->db) == 0) {
-    sqlite3_reset(stmt);
-    return ORDO_ERROR_TASK_NOT_FOUND;
+  task_list_clear(&db->returned);
+  OrdoResult result = step_returning(db, stmt, row);
+  if (op == DB_WRITE_ADD && result == ORDO_ERROR_TASK_NOT_FOUND) {
+    return ORDO_ERROR_DATABASE;
   }
+  return result;
+}
 
+// --- Transactions ---
+
+// Steps a statement that returns no rows.
+static OrdoResult exec_stmt(Database *db, sqlite3_stmt *stmt) {
+  int rc = sqlite3_step(stmt);
   sqlite3_reset(stmt);
+  if (rc != SQLITE_DONE) {
+    fprintf(stderr, "Error executing '%s': %s\n", sqlite3_sql(stmt),
+            sqlite3_errmsg(db->db));
+    return ORDO_ERROR_DATABASE;
+  }
   return ORDO_OK;
 }
 
-OrdoResult database_update_task_description(Database *db, int task_id,
-                                            const char *new_description) {
-  if (new_description == NULL || strlen(new_description) == 0) {
-    return ORDO_ERROR_EMPTY_DESCRIPTION;
-  }
+OrdoResult database_begin(Database *db) {
+  return exec_stmt(db, db->begin_stmt);
+}
 
-  sqlite3_stmt *stmt = db->update_task_description_stmt;
-  sqlite3_bind_text(stmt, 1, new_description, -1, SQLITE_TRANSIENT);
-  sqlite3_bind_int(stmt, 2, task_id);
+OrdoResult database_commit(Database *db) {
+  return exec_stmt(db, db->commit_stmt);
+}
 
-  if (sqlite3_step(stmt) != SQLITE_DONE) {
-    sqlite3_reset(stmt);
-    return ORDO_ERROR_DATABASE;
+OrdoResult database_rollback(Database *db) {
+  return exec_stmt(db, db->rollback_stmt);
+}
+
+// --- Maintenance Functions ---
+
+OrdoResult database_purge_trash(Database *db, const TrashRetention *policy,
+                                int limit, int *purged) {
+  *purged = 0;
+  if (policy->max_age_days > 0) {
+    sqlite3_stmt *stmt = db->purge_expired_stmt;
+    sqlite3_bind_int64(stmt, 1,
+                       (sqlite3_int64)time(NULL) -
+                           (sqlite3_int64)policy->max_age_days * 86400);
+    sqlite3_bind_int(stmt, 2, limit);
+    if (exec_stmt(db, stmt) != ORDO_OK)
+      return ORDO_ERROR_DATABASE;
+    *purged += sqlite3_changes(db->db);
   }
 
-  if (sqlite3_changes(db->db) == 0) {
-    sqlite3_reset(stmt);
-    return ORDO_ERROR_TASK_NOT_FOUND;
+  if (policy->max_tasks > 0 && *purged < limit) {
+    sqlite3_stmt *stmt = db->purge_excess_stmt;
+    sqlite3_bind_int(stmt, 1, policy->max_tasks);
+    sqlite3_bind_int(stmt, 2, limit - *purged);
+    if (exec_stmt(db, stmt) != ORDO_OK)
+      return ORDO_ERROR_DATABASE;
+    *purged += sqlite3_changes(db->db);
   }
+  return ORDO_OK;
+}
 
+OrdoResult database_prune_changes(Database *db, int keep, int limit,
+                                  bool *more) {
+  *more = false;
+  sqlite3_int64 floor = 0;
+  sqlite3_stmt *stmt = db->prune_range_stmt;
+  sqlite3_bind_int(stmt, 1, keep);
+  sqlite3_bind_int(stmt, 2, limit);
+  bool ok = sqlite3_step(stmt) == SQLITE_ROW;
+  bool found = ok && sqlite3_column_type(stmt, 0) != SQLITE_NULL;
+  if (found) {
+    floor = sqlite3_column_int64(stmt, 0);
+    *more = sqlite3_column_int(stmt, 1) == limit;
+  }
   sqlite3_reset(stmt);
+  if (!ok)
+    return ORDO_ERROR_DATABASE;
+  if (!found)
+    return ORDO_OK; // No entry old enough above the floor
+
+  sqlite3_bind_int64(db->prune_changes_stmt, 1, floor);
+  sqlite3_bind_int64(db->raise_floor_stmt, 1, floor);
+  if (exec_stmt(db, db->prune_changes_stmt) != ORDO_OK ||
+      exec_stmt(db, db->raise_floor_stmt) != ORDO_OK)
+    return ORDO_ERROR_DATABASE;
   return ORDO_OK;
 }
+
+OrdoResult database_vacuum_step(Database *db, int pages, bool *more) {
+  char sql[64];
+  safe_snprintf(sql, sizeof(sql), "PRAGMA incremental_vacuum(%d);", pages);
+  sqlite3_int64 before = 0;
+  sqlite3_int64 after = 0;
+  if (!read_int64(db->freelist_count_stmt, &before) ||
+      exec_sql(db->db, sql) != ORDO_OK ||
+      !read_int64(db->freelist_count_stmt, &after))
+    return ORDO_ERROR_DATABASE;
+  // Nothing is released outside incremental mode, however many pages are free.
+  *more = after > 0 && after < before;
+  return ORDO_OK;
+}
+
+OrdoResult database_compact(Database *db) {
+  return exec_sql(db->db, "PRAGMA auto_vacuum = INCREMENTAL; VACUUM;");
+}
+
+// Returns true if the plan of `stmt` reads one of the partial task indexes.
+static bool check_plan(sqlite3 *db, const char *name, sqlite3_stmt *stmt,
+                       FILE *out) {
+  char sql[512];
+  sqlite3_stmt *plan;
+  safe_snprintf(sql, sizeof(sql), "EXPLAIN QUERY PLAN %s", sqlite3_sql(stmt));
+  if (sqlite3_prepare_v2(db, sql, -1, &plan, NULL) != SQLITE_OK) {
+    fprintf(out, "  %-22s error: %s\n", name, sqlite3_errmsg(db));
+    return false;
+  }
+
+  bool uses_index = false;
+  char detail[256] = "";
+  while (sqlite3_step(plan) == SQLITE_ROW) {
+    const char *text = (const char *)sqlite3_column_text(plan, 3);
+    if (!text)
+      continue;
+    safe_snprintf(detail, sizeof(detail), "%s", text);
+    if (strstr(text, "USING COVERING INDEX idx_tasks_"))
+      uses_index = true;
+  }
+  sqlite3_finalize(plan);
+
+  fprintf(out, "  %-22s %-4s %s\n", name, uses_index ? "ok" : "FAIL", detail);
+  return uses_index;
+}
+
+bool database_check_query_plans(Database *db, FILE *out) {
+  const struct {
+    const char *name;
+    sqlite3_stmt *stmt;
+  } queries[] = {
+      {"load active", db->load_tasks_stmt},
+      {"load deleted", db->load_deleted_tasks_stmt},
+      {"count active", db->count_tasks_stmt[0]},
+      {"count deleted", db->count_tasks_stmt[1]},
+      {"page active forward", db->page_forward_stmt[0]},
+      {"page active backward", db->page_backward_stmt[0]},
+      {"page deleted forward", db->page_forward_stmt[1]},
+      {"page deleted backward", db->page_backward_stmt[1]},
+  };
+
+  bool all_ok = true;
+  fprintf(out, "Query plans:\n");
+  for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i) {
+    if (!check_plan(db->db, queries[i].name, queries[i].stmt, out))
+      all_ok = false;
+  }
+  return all_ok;
+}
@@ -16,6 +16,45 @@
 #include "task.h"
 #include "task_list.h"
 #include <sqlite3.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/**
+ * @enum StorageProfile
+ * @brief Named sets of connection pragmas trading durability for speed.
+ */
+typedef enum {
+  STORAGE_DURABLE,            /**< Rollback journal, full fsync on every commit. */
+  STORAGE_BALANCED,           /**< WAL with normal sync; may lose the last commits on power loss. */
+  STORAGE_FAST,               /**< WAL without fsync and a large cache; may lose recent commits on OS crash. */
+  STORAGE_MEMORY_CONSTRAINED, /**< Small page cache, no mmap, temporary data on disk. */
+  STORAGE_PROFILE_COUNT
+} StorageProfile;
+
+#define STORAGE_DEFAULT_PROFILE STORAGE_DURABLE
+
+/**
+ * @enum DatabaseWrite
+ * @brief The kinds of single-task mutations, as run by `database_write_row`.
+ */
+typedef enum {
+  DB_WRITE_ADD,         /**< Insert a task with the given description. */
+  DB_WRITE_REMOVE,      /**< Move a task to the trash. */
+  DB_WRITE_RESTORE,     /**< Restore a task from the trash. */
+  DB_WRITE_PERM_DELETE, /**< Delete a task permanently. */
+  DB_WRITE_TOGGLE,      /**< Set the status of a task. */
+  DB_WRITE_EDIT,        /**< Replace the description of a task. */
+  DB_WRITE_PURGE        /**< Apply the trash retention policy (not a row mutation). */
+} DatabaseWrite;
+
+/**
+ * @struct TrashRetention
+ * @brief When tasks in the trash are deleted for good.
+ */
+typedef struct {
+  int max_age_days; /**< Days a task stays in the trash, or 0 for no limit. */
+  int max_tasks;    /**< Tasks the trash holds before the oldest go, or 0 for no limit. */
+} TrashRetention;
 
 /**
  * @struct Database
@@ -26,6 +65,7 @@
  */
 typedef struct {
   sqlite3 *db;                                /**< Pointer to the SQLite database connection. */
+  StorageProfile profile;                     /**< Storage profile applied when the connection was set up. */
   sqlite3_stmt *add_task_stmt;                /**< Statement to add a new task. */
   sqlite3_stmt *remove_task_stmt;             /**< Statement to move a task to the trash. */
   sqlite3_stmt *toggle_task_status_stmt;      /**< Statement to toggle the state (completed/pending) of a task. */
@@ -34,15 +74,75 @@ typedef struct {
   sqlite3_stmt *restore_task_stmt;            /**< Statement to restore a task from the trash. */
   sqlite3_stmt *perm_delete_task_stmt;        /**< Statement to permanently delete a task. */
   sqlite3_stmt *load_deleted_tasks_stmt;      /**< Statement to load tasks from the trash. */
+  sqlite3_stmt *count_tasks_stmt[2];          /**< Statements to count active ([0]) and trashed ([1]) tasks. */
+  sqlite3_stmt *page_forward_stmt[2];         /**< Statements to load a page of tasks after a given ID. */
+  sqlite3_stmt *page_backward_stmt[2];        /**< Statements to load a page of tasks before a given ID. */
+  sqlite3_stmt *begin_stmt;                   /**< Statement to begin a write transaction. */
+  sqlite3_stmt *commit_stmt;                  /**< Statement to commit the current transaction. */
+  sqlite3_stmt *rollback_stmt;                /**< Statement to roll back the current transaction. */
+  sqlite3_stmt *data_version_stmt;            /**< Statement to read `PRAGMA data_version`. */
+  sqlite3_stmt *change_rev_stmt;              /**< Statement to read the latest change number. */
+  sqlite3_stmt *changes_since_stmt;           /**< Statement to list the tasks changed after a change number. */
+  sqlite3_stmt *change_floor_stmt;            /**< Statement to read the change number below which the log was pruned. */
+  sqlite3_stmt *count_before_stmt[2];         /**< Statements to count the tasks of a view before a given ID. */
+  sqlite3_stmt *search_stmt;                  /**< Statement to search the task descriptions. */
+  sqlite3_stmt *search_probe_stmt;            /**< Statement to count the full-text matches, up to a limit. */
+  sqlite3_stmt *search_unranked_stmt;         /**< Statement to list full-text matches without ranking them. */
+  bool full_text_search;                      /**< Whether `search_stmt` uses the FTS5 index rather than `LIKE`. */
+  sqlite3_stmt *purge_expired_stmt;           /**< Statement to delete trashed tasks older than a cutoff. */
+  sqlite3_stmt *purge_excess_stmt;            /**< Statement to delete the oldest trashed tasks beyond a count. */
+  sqlite3_stmt *freelist_count_stmt;          /**< Statement to read `PRAGMA freelist_count`. */
+  sqlite3_stmt *prune_range_stmt;             /**< Statement to find the next batch of old change log entries. */
+  sqlite3_stmt *prune_changes_stmt;           /**< Statement to delete the entries of deleted tasks up to a change number. */
+  sqlite3_stmt *raise_floor_stmt;             /**< Statement to record the change number the log was pruned up to. */
+  sqlite3_int64 data_version;                 /**< `PRAGMA data_version` when changes were last looked for. */
+  sqlite3_int64 synced_rev;                   /**< The latest change reflected in the loaded task list. */
+  TaskList returned;                          /**< The rows returned by the last mutation; owns their descriptions. */
 } Database;
 
 /**
  * @brief Initializes the database connection and prepares the statements.
+ *
+ * The pragmas of `profile` are applied before the schema is created, so the
+ * page size only takes effect on a new database file.
  * @param[in] db_conn An open SQLite connection.
+ * @param[in] profile The storage profile to configure the connection with.
  * @param[out] db Pointer to the `Database` structure to be initialized.
  * @return `ORDO_OK` on success, or an error code on failure.
  */
-OrdoResult database_init(sqlite3 *db_conn, Database *db);
+OrdoResult database_init(sqlite3 *db_conn, StorageProfile profile,
+                         Database *db);
+
+/**
+ * @brief Returns the configuration name of a storage profile.
+ * @param[in] profile The storage profile.
+ * @return A static string such as `"balanced"`.
+ */
+const char *database_profile_name(StorageProfile profile);
+
+/**
+ * @brief Looks up a storage profile by its configuration name.
+ * @param[in] name The name, e.g. `"fast"` or `"memory-constrained"`.
+ * @param[out] profile Receives the profile if the name is known.
+ * @return `true` if the name was recognized.
+ */
+bool database_profile_from_name(const char *name, StorageProfile *profile);
+
+/**
+ * @brief Writes the active storage profile and the effective pragma values.
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in] out The stream to write the report to.
+ */
+void database_print_storage_info(Database *db, FILE *out);
+
+/**
+ * @brief Verifies with `EXPLAIN QUERY PLAN` that the view queries use the
+ * partial covering indexes instead of scanning the whole table.
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in] out The stream to write the plan of each query to.
+ * @return `true` if every query reads one of the indexes.
+ */
+bool database_check_query_plans(Database *db, FILE *out);
 
 /**
  * @brief Finalizes the prepared statements and closes the database connection.
@@ -52,6 +152,9 @@ void database_close(Database *db);
 
 /**
  * @brief Loads the active tasks (not in the trash) from the database.
+ *
+ * In windowed mode only the number of tasks is read; the rows themselves are
+ * fetched on demand by `database_load_window`.
  * @param[in] db Pointer to the `Database` structure.
  * @param[out] list Pointer to the `TaskList` where the tasks will be loaded.
  * @return `ORDO_OK` on success.
@@ -67,57 +170,187 @@ OrdoResult database_load_tasks(Database *db, TaskList *list);
 OrdoResult database_load_deleted_tasks(Database *db, TaskList *list);
 
 /**
- * @brief Adds a new task to the database.
+ * @brief Slides the window of a windowed task list over the given positions.
+ *
+ * Does nothing if the positions are already in memory or the list is not
+ * windowed. Otherwise the visible page plus a margin is fetched with keyset
+ * pagination on `id`, anchored on the closest row already known: the ends of
+ * the view or the edges of the current window.
+ *
+ * Scrolling next to the window and jumping to either end seek straight to the
+ * anchor and read only the page. SQLite cannot seek to a position, so a jump
+ * away from every known row, such as several pages at once or the middle of
+ * the view, still steps over the rows between the anchor and the page: it
+ * costs O(distance) rather than O(page).
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in,out] list Pointer to a `TaskList` loaded by `database_load_tasks`
+ * or `database_load_deleted_tasks`.
+ * @param[in] first The first visible position.
+ * @param[in] visible The number of visible positions.
+ * @return `ORDO_OK` on success.
+ */
+OrdoResult database_load_window(Database *db, TaskList *list, int first,
+                                int visible);
+
+/**
+ * @brief Merges into a task list the changes committed by other connections.
+ *
+ * Every write to `tasks` is stamped with a database-wide change number. The
+ * cheap `PRAGMA data_version` check tells whether anything was committed since
+ * the last call; only then are the tasks changed after the last change number
+ * seen read and patched into the list. Call it periodically, e.g. on the idle
+ * tick of the main loop.
+ *
+ * Rows the list already reflects are simply applied again. A list that still
+ * holds provisional rows (see `writer.h`) must not be synced until their
+ * writes are acknowledged. If the list was synced before the oldest change
+ * still logged (see `database_prune_changes`), it is left as is and
+ * `ORDO_ERROR_GENERIC` is returned.
+ * @param[in] db Pointer to the `Database` the list was loaded from.
+ * @param[in,out] list A list loaded by `database_load_tasks` or
+ * `database_load_deleted_tasks`.
+ * @return `ORDO_OK` on success. On failure the list should be reloaded.
+ */
+OrdoResult database_sync_changes(Database *db, TaskList *list);
+
+/**
+ * @brief Searches the descriptions of the tasks of a view.
+ *
+ * Every word of `text` must match the start of a word of the description, so
+ * results appear while the last word is still being typed. Results are ranked
+ * by relevance (BM25), unless the text matches too many tasks to rank quickly,
+ * in which case they come in ID order. Without FTS5 support in SQLite, the
+ * whole text is matched as a substring instead and results come in ID order.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] description The description of the new task.
- * @param[out] new_task_id Pointer to store the ID of the newly created task.
+ * @param[in] text The text typed by the user.
+ * @param[in] deleted_scope The view to search: 0 for active tasks, 1 for the
+ * trash.
+ * @param[in] limit The maximum number of results.
+ * @param[out] results Receives the matching tasks, best first. Empty if `text`
+ * holds no words.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_add_task(Database *db, const char *description,
-                             int *new_task_id);
+OrdoResult database_search_tasks(Database *db, const char *text,
+                                 int deleted_scope, int limit,
+                                 TaskList *results);
 
 /**
- * @brief Moves a task to the trash (soft delete).
+ * @brief Finds the position of a task within the view of a task list.
+ * @param[in] db Pointer to the `Database` the list was loaded from.
+ * @param[in] list The task list.
+ * @param[in] task_id The ID of a task belonging to the view.
+ * @param[out] position Receives the position, e.g. to select the task.
+ * @return `ORDO_OK` on success, `ORDO_ERROR_TASK_NOT_FOUND` if a fully loaded
+ * list does not hold the task or its active view leaves it out.
+ */
+OrdoResult database_find_position(Database *db, const TaskList *list,
+                                  int task_id, int *position);
+
+// --- Mutation Functions ---
+// Mutations are run by the background writer (see `writer.h`), which groups
+// them into one transaction per batch of queued commands and patches the UI's
+// task list itself.
+
+/**
+ * @brief Begins an explicit write transaction.
+ *
+ * Mutations issued until `database_commit` or `database_rollback` share a
+ * single commit.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] task_id The ID of the task to be moved to the trash.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_remove_task(Database *db, int task_id);
+OrdoResult database_begin(Database *db);
 
 /**
- * @brief Restores a task from the trash.
+ * @brief Commits the transaction opened by `database_begin`.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] task_id The ID of the task to be restored.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_restore_task(Database *db, int task_id);
+OrdoResult database_commit(Database *db);
 
 /**
- * @brief Permanently deletes a task from the database.
+ * @brief Discards the transaction opened by `database_begin`.
+ *
+ * Task lists patched since the transaction began no longer match the
+ * database and must be reloaded.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] task_id The ID of the task to be permanently deleted.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_permanently_delete_task(Database *db, int task_id);
+OrdoResult database_rollback(Database *db);
 
 /**
- * @brief Toggles the status of a task between completed and pending.
+ * @brief Runs a single mutation and returns the affected row.
+ *
+ * Runs in the caller's transaction, if any.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] task_id The ID of the task to be modified.
- * @param[in] current_status The current status of the task (0 for pending, 1 for completed).
+ * @param[in] op The mutation to run.
+ * @param[in] task_id The ID of the task (ignored by `DB_WRITE_ADD`).
+ * @param[in] status The new status for `DB_WRITE_TOGGLE`.
+ * @param[in] description The description for `DB_WRITE_ADD` and `DB_WRITE_EDIT`.
+ * @param[out] row Receives the row as stored after the mutation. Its
+ * description is valid until the next mutation on `db`.
+ * @return `ORDO_OK` on success, `ORDO_ERROR_TASK_NOT_FOUND` if no task matched.
+ */
+OrdoResult database_write_row(Database *db, DatabaseWrite op, int task_id,
+                              int status, const char *description, Task *row);
+
+// --- Maintenance Functions ---
+
+/**
+ * @brief Deletes for good up to `limit` trashed tasks that the retention
+ * policy no longer keeps, oldest first.
+ *
+ * Runs in the caller's transaction, if any. Call it repeatedly, e.g. while
+ * idle, until it purges fewer than `limit` tasks.
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in] policy The retention policy.
+ * @param[in] limit The maximum number of tasks to delete.
+ * @param[out] purged Receives the number of tasks deleted.
+ * @return `ORDO_OK` on success.
+ */
+OrdoResult database_purge_trash(Database *db, const TrashRetention *policy,
+                                int limit, int *purged);
+
+/**
+ * @brief Drops from the change log a batch of the entries of deleted tasks.
+ *
+ * A deleted task keeps its entry in the change log so that other instances
+ * learn about the deletion. Entries older than the `keep` latest changes are
+ * scanned `limit` at a time, in order; those of deleted tasks are removed and
+ * the log's floor is raised to the last one scanned. Instances that last
+ * synced below the floor reload their view instead. Runs in the caller's
+ * transaction, if any.
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in] keep The number of latest changes always kept; must be positive.
+ * @param[in] limit The maximum number of entries to scan.
+ * @param[out] more Receives whether entries are left to scan.
+ * @return `ORDO_OK` on success.
+ */
+OrdoResult database_prune_changes(Database *db, int keep, int limit,
+                                  bool *more);
+
+/**
+ * @brief Returns up to `pages` free pages to the file system.
+ *
+ * Only shrinks the file of a database in incremental auto-vacuum mode: every
+ * database created by this version, and older ones once compacted by
+ * `database_compact`. Elsewhere the free pages are reused for new rows.
+ * @param[in] db Pointer to the `Database` structure.
+ * @param[in] pages The maximum number of pages to release; must be positive.
+ * @param[out] more Receives whether free pages are left to release.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_toggle_task_status(Database *db, int task_id,
-                                       int current_status);
+OrdoResult database_vacuum_step(Database *db, int pages, bool *more);
 
 /**
- * @brief Updates the description of an existing task.
+ * @brief Rewrites the database file without its free pages and switches it
+ * to incremental auto-vacuum.
+ *
+ * A full `VACUUM`: it blocks every other connection until done and needs
+ * free disk space for a copy of the file. Used by `ordo --compact`.
  * @param[in] db Pointer to the `Database` structure.
- * @param[in] task_id The ID of the task to be updated.
- * @param[in] new_description The new description for the task.
  * @return `ORDO_OK` on success.
  */
-OrdoResult database_update_task_description(Database *db, int task_id,
-                                            const char *new_description);
+OrdoResult database_compact(Database *db);
 
 #endif // DATABASE_H
@@ -0,0 +1,238 @@
+#define _GNU_SOURCE // ppoll
+#include "event_loop.h"
+#include <errno.h>
+#include <ncurses.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <stdalign.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+#endif
+
+#define MS_PER_MINUTE 60000
+
+// Milliseconds until the wall clock reaches the next minute.
+static int until_next_minute(void) {
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  long elapsed = (long)(now.tv_sec % 60) * 1000 + now.tv_nsec / 1000000;
+  return (int)(MS_PER_MINUTE - elapsed);
+}
+
+// How long the wait may sleep. `tick` tells whether running out of time
+// means the minute changed.
+static int wait_timeout(const EventLoop *loop, int max_wait_ms, bool *tick) {
+  *tick = false;
+  if (loop->timer_fd >= 0)
+    return max_wait_ms;
+  int minute = until_next_minute();
+  if (max_wait_ms >= 0 && max_wait_ms < minute)
+    return max_wait_ms;
+  *tick = true;
+  return minute;
+}
+
+#ifdef __linux__
+// Arms the timer to every wall-clock minute from the next one on. Setting the
+// clock cancels it, so the clock is redrawn and the timer armed again.
+static bool arm_timer(int fd) {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  struct itimerspec spec = {
+      .it_interval = {.tv_sec = 60},
+      .it_value = {.tv_sec = now.tv_sec - now.tv_sec % 60 + 60},
+  };
+  return timerfd_settime(fd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET,
+                         &spec, NULL) == 0;
+}
+
+// Whether the timer expired since it was last read.
+static bool read_timer(int fd) {
+  uint64_t expirations;
+  if (read(fd, &expirations, sizeof(expirations)) > 0)
+    return true;
+  if (errno == ECANCELED) {
+    arm_timer(fd);
+    return true;
+  }
+  return false;
+}
+
+// Whether any of the queued inotify events concerns the database or one of
+// its journals; the other files of the directory are ignored.
+static bool read_database_events(const EventLoop *loop) {
+  alignas(struct inotify_event) char buffer[4096];
+  size_t name_len = strlen(loop->database_name);
+  bool changed = false;
+  ssize_t len;
+  while ((len = read(loop->database_fd, buffer, sizeof(buffer))) > 0) {
+    for (ssize_t offset = 0; offset < len;) {
+      const struct inotify_event *event =
+          (const struct inotify_event *)(buffer + offset);
+      if (event->len > 0 &&
+          strncmp(event->name, loop->database_name, name_len) == 0)
+        changed = true;
+      offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+    }
+  }
+  return changed;
+}
+#endif
+
+#ifndef _WIN32
+// Empties a notification pipe.
+static void drain(int fd) {
+  char buffer[64];
+  while (read(fd, buffer, sizeof(buffer)) > 0) {
+  }
+}
+#endif
+
+void event_loop_init(EventLoop *loop) {
+  *loop = (EventLoop){.timer_fd = -1, .writer_fd = -1, .database_fd = -1};
+#ifdef __linux__
+  loop->timer_fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (loop->timer_fd >= 0 && !arm_timer(loop->timer_fd)) {
+    close(loop->timer_fd);
+    loop->timer_fd = -1;
+  }
+#endif
+}
+
+void event_loop_free(EventLoop *loop) {
+#ifndef _WIN32
+  if (loop->timer_fd >= 0)
+    close(loop->timer_fd);
+  if (loop->database_fd >= 0)
+    close(loop->database_fd);
+#endif
+  free(loop->database_name);
+  *loop = (EventLoop){.timer_fd = -1, .writer_fd = -1, .database_fd = -1};
+}
+
+void event_loop_watch_writer(EventLoop *loop, int fd) { loop->writer_fd = fd; }
+
+void event_loop_watch_database(EventLoop *loop, const char *db_path) {
+#ifdef __linux__
+  // The journals come and go, so the directory is watched rather than the
+  // files.
+  const char *slash = strrchr(db_path, '/');
+  size_t dir_len = slash > db_path ? (size_t)(slash - db_path) : 1;
+  char *dir = slash ? strndup(db_path, dir_len) : strdup(".");
+  char *name = strdup(slash ? slash + 1 : db_path);
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  // A commit writes the WAL or, in rollback mode, writes the database and
+  // deletes the journal.
+  if (dir && name && fd >= 0 &&
+      inotify_add_watch(fd, dir, IN_MODIFY | IN_DELETE) >= 0) {
+    loop->database_fd = fd;
+    loop->database_name = name;
+    name = NULL;
+  } else if (fd >= 0) {
+    close(fd);
+  }
+  free(dir);
+  free(name);
+#else
+  (void)loop;
+  (void)db_path;
+#endif
+}
+
+int event_loop_poll_key(EventLoop *loop) {
+  (void)loop;
+  nodelay(stdscr, TRUE);
+  int key = getch();
+  nodelay(stdscr, FALSE);
+  return key;
+}
+
+#ifdef _WIN32
+// PDCurses input cannot be polled together with other sources, so the wait
+// is a getch() timeout.
+unsigned int event_loop_wait(EventLoop *loop, int max_wait_ms, int *key) {
+  bool tick;
+  timeout(wait_timeout(loop, max_wait_ms, &tick));
+  *key = getch();
+  timeout(-1);
+  if (*key != ERR)
+    return EVENT_INPUT;
+  return tick ? EVENT_TICK : 0;
+}
+#else
+unsigned int event_loop_wait(EventLoop *loop, int max_wait_ms, int *key) {
+  // SIGWINCH stays blocked from the check for keys until the poll, which
+  // unblocks it atomically, so a resize in between interrupts the poll
+  // instead of going unnoticed until the next event.
+  sigset_t resize, unblocked;
+  sigemptyset(&resize);
+  sigaddset(&resize, SIGWINCH);
+  pthread_sigmask(SIG_BLOCK, &resize, &unblocked);
+
+  unsigned int events = 0;
+  nodelay(stdscr, TRUE);
+  *key = getch(); // ncurses may hold keys it already read from the terminal
+  if (*key == ERR) {
+    struct pollfd fds[4];
+    int count = 0;
+    fds[count++] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
+    int sources[] = {loop->timer_fd, loop->writer_fd, loop->database_fd};
+    for (int i = 0; i < 3; i++) {
+      if (sources[i] >= 0)
+        fds[count++] = (struct pollfd){.fd = sources[i], .events = POLLIN};
+    }
+
+    bool tick;
+    int timeout_ms = wait_timeout(loop, max_wait_ms, &tick);
+#ifdef __linux__
+    struct timespec limit = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    int ready =
+        ppoll(fds, (nfds_t)count, timeout_ms >= 0 ? &limit : NULL, &unblocked);
+#else
+    pthread_sigmask(SIG_SETMASK, &unblocked, NULL);
+    int ready = poll(fds, (nfds_t)count, timeout_ms);
+#endif
+
+    if (ready == 0 && tick)
+      events |= EVENT_TICK;
+    for (int i = 1; ready > 0 && i < count; i++) {
+      if (!(fds[i].revents & POLLIN))
+        continue;
+      if (fds[i].fd == loop->timer_fd) {
+#ifdef __linux__
+        if (read_timer(loop->timer_fd))
+          events |= EVENT_TICK;
+#endif
+      } else if (fds[i].fd == loop->writer_fd) {
+        drain(loop->writer_fd);
+        events |= EVENT_WRITER;
+      } else {
+#ifdef __linux__
+        if (read_database_events(loop))
+          events |= EVENT_DATABASE;
+#endif
+      }
+    }
+    // An interrupted poll is most likely a resize, which getch() reports.
+    if ((ready > 0 && fds[0].revents) || (ready < 0 && errno == EINTR))
+      *key = getch();
+  }
+  nodelay(stdscr, FALSE);
+  pthread_sigmask(SIG_SETMASK, &unblocked, NULL);
+
+  if (*key != ERR)
+    events |= EVENT_INPUT;
+  return events;
+}
+#endif
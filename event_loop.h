@@ -0,0 +1,98 @@
+/**
+ * @file event_loop.h
+ * @brief Waits for whatever the main loop has to react to, without waking up
+ * in between.
+ *
+ * The main loop sleeps until a key is typed, the wall clock reaches a new
+ * minute (the only change the sidebar clock shows), the writer posts an
+ * acknowledgement or another process commits to the database. An idle Ordo
+ * therefore uses no CPU between two minutes.
+ *
+ * On Linux every source is a file descriptor polled together with the
+ * terminal: a timerfd armed to the minute boundaries, the writer's
+ * notification pipe and an inotify watch on the database directory. Where a
+ * source is missing, the wait falls back to a timeout: the next minute
+ * boundary for the clock, and `max_wait_ms` for the rest.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+/**
+ * @enum EventKind
+ * @brief The events `event_loop_wait` reports, as bits of a mask.
+ */
+typedef enum {
+  EVENT_INPUT = 1 << 0,    /**< A key was read. */
+  EVENT_TICK = 1 << 1,     /**< The wall clock reached a new minute. */
+  EVENT_WRITER = 1 << 2,   /**< The writer posted acknowledgements. */
+  EVENT_DATABASE = 1 << 3, /**< The database files changed on disk. */
+} EventKind;
+
+/**
+ * @struct EventLoop
+ * @brief The sources the main loop waits on.
+ */
+typedef struct {
+  int timer_fd;        /**< Expires at every minute boundary, or -1. */
+  int writer_fd;       /**< Readable once the writer posted acknowledgements, or -1. */
+  int database_fd;     /**< inotify instance watching the database directory, or -1. */
+  char *database_name; /**< File name of the database, whose journals share it as a prefix. */
+} EventLoop;
+
+/**
+ * @brief Sets up the clock source. Without a timerfd, ticks come from the
+ * wait's timeout.
+ * @param[out] loop Pointer to the `EventLoop` to be initialized.
+ */
+void event_loop_init(EventLoop *loop);
+
+/**
+ * @brief Closes every source.
+ * @param[in] loop Pointer to the `EventLoop`.
+ */
+void event_loop_free(EventLoop *loop);
+
+/**
+ * @brief Wakes the loop when the writer posts acknowledgements.
+ * @param[in,out] loop Pointer to the `EventLoop`.
+ * @param[in] fd The writer's notification descriptor (see
+ * `writer_event_fd`), or -1. The writer keeps ownership of it.
+ */
+void event_loop_watch_writer(EventLoop *loop, int fd);
+
+/**
+ * @brief Wakes the loop when the database or one of its journals is written.
+ *
+ * Commits by this process wake the loop as well; the check that follows is
+ * cheap. Only available on Linux; elsewhere commits by other processes are
+ * picked up at the next event.
+ * @param[in,out] loop Pointer to the `EventLoop`.
+ * @param[in] db_path The path of the database file.
+ */
+void event_loop_watch_database(EventLoop *loop, const char *db_path);
+
+/**
+ * @brief Reads a key, or sleeps until the next event if none was typed.
+ *
+ * Keys ncurses already buffered are returned at once. A terminal resize
+ * wakes the wait and is returned as `KEY_RESIZE`. Uses `stdscr`, which is
+ * left in blocking mode for the loops of popups and other screens.
+ * @param[in,out] loop Pointer to the `EventLoop`.
+ * @param[in] max_wait_ms The longest to sleep, or -1 to sleep until an event.
+ * @param[out] key Receives the key, or `ERR` if none was typed.
+ * @return The events that happened, as a mask of `EventKind`; 0 if the wait
+ * timed out before any.
+ */
+unsigned int event_loop_wait(EventLoop *loop, int max_wait_ms, int *key);
+
+/**
+ * @brief Reads a key that was already typed, without waiting.
+ *
+ * Used to handle the typeahead before the next frame is drawn.
+ * @param[in,out] loop Pointer to the `EventLoop`.
+ * @return The key, or `ERR` if none is pending.
+ */
+int event_loop_poll_key(EventLoop *loop);
+
+#endif // EVENT_LOOP_H
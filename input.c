@@ -2,9 +2,12 @@
 #include "app.h"
 #include "database.h"
 #include "error.h"
+#include "perf_stats.h"
 #include "settings_ui.h"
 #include "ui.h"
 #include "utils.h"
+#include <stdlib.h>
+#include <wctype.h>
 
 // Helper function to display result messages in the UI
 static void handle_result(OrdoResult result, AppState *app) {
@@ -59,12 +62,203 @@ static void handle_result(OrdoResult result, AppState *app) {
   }
 }
 
+// Marks or unmarks the selected task and moves on to the next one
+static void toggle_mark(AppState *app, const Task *selected) {
+  if (!selected)
+    return;
+  task_marks_toggle(&app->marks, selected);
+  if (app->current_selection + 1 < task_list_total(&app->task_list))
+    app->current_selection++;
+}
+
+// Returns the current status of every marked task, taken from the task list
+// when the task is loaded and from the mark otherwise. Must be freed.
+static int *marked_statuses(const AppState *app) {
+  int *statuses = malloc(sizeof(int) * (size_t)app->marks.count);
+  if (!statuses)
+    return NULL;
+  for (int i = 0; i < app->marks.count; i++) {
+    int index = task_list_find(&app->task_list, app->marks.ids[i]);
+    statuses[i] = index >= 0 ? app->task_list.tasks[index].concluida
+                             : app->marks.states[i];
+  }
+  return statuses;
+}
+
+// Moves every marked task to the trash in a single write
+static void trash_marked(AppState *app) {
+  if (!ui_confirm_action("CONFIRM_TRASH_PROMPT", "MENU_REMOVE", &app->config))
+    return;
+  unsigned long seq = 0;
+  OrdoResult result =
+      writer_remove_tasks(&app->writer, app->marks.ids, app->marks.count,
+                          &app->task_list, &seq);
+  if (result == ORDO_OK) {
+    undo_manager_push_batch(&app->undo_manager, ACTION_DELETE_MANY,
+                            app->marks.ids, NULL, app->marks.count, seq);
+    app_hold_marks(app, seq);
+    handle_result(ORDO_TRASH_SUCCESS, app);
+  } else {
+    handle_result(result, app);
+  }
+}
+
+// Toggles every marked task in a single write
+static void toggle_marked(AppState *app) {
+  if (!ui_confirm_action("CONFIRM_TOGGLE_PROMPT", "MENU_TOGGLE", &app->config))
+    return;
+  int *statuses = marked_statuses(app);
+  if (!statuses) {
+    handle_result(ORDO_ERROR_GENERIC, app);
+    return;
+  }
+  bool any_pending = false;
+  for (int i = 0; i < app->marks.count; i++)
+    any_pending = any_pending || !statuses[i];
+
+  unsigned long seq = 0;
+  OrdoResult result =
+      writer_toggle_tasks_status(&app->writer, app->marks.ids, statuses,
+                                 app->marks.count, &app->task_list, &seq);
+  if (result == ORDO_OK) {
+    undo_manager_push_batch(&app->undo_manager, ACTION_TOGGLE_MANY,
+                            app->marks.ids, statuses, app->marks.count, seq);
+    app_hold_marks(app, seq);
+    handle_result(any_pending ? ORDO_TOGGLE_SUCCESS_DONE
+                              : ORDO_TOGGLE_SUCCESS_REOPEN,
+                  app);
+  } else {
+    handle_result(result, app);
+  }
+  free(statuses);
+}
+
+// --- Incremental Search ---
+
+// Shows the next filtered or sorted view of the task list, keeping the
+// selected task selected if the new view shows it
+static void cycle_list_view(AppState *app) {
+  TaskViewKind next = (app->task_list.view + 1) % TASK_VIEW_COUNT;
+  int selected_id = app_selected_task_id(app);
+  if (!task_list_set_view(&app->task_list, next)) {
+    ui_show_message("LIST_VIEW_UNAVAILABLE", true, &app->config);
+    return;
+  }
+  app->current_selection = 0;
+  app_select_task(app, selected_id);
+  ui_show_message(ui_view_name_key(next), false, &app->config);
+}
+
+// Maximum number of results listed while searching
+#define SEARCH_RESULT_LIMIT 200
+#define SEARCH_MAX_QUERY 128
+
+// Selects the chosen search result in the view
+static void choose_search_result(AppState *app, const TaskList *results,
+                                 int selection) {
+  const Task *chosen = task_list_at(results, selection);
+  if (!chosen)
+    return;
+  // Searches cover the whole scope; show every task if the view hid it.
+  int index = task_list_find(&app->task_list, chosen->id);
+  if (index >= 0 && task_list_position(&app->task_list, index) < 0)
+    task_list_set_view(&app->task_list, TASK_VIEW_ALL);
+  app_select_task(app, chosen->id);
+}
+
+// Searches the current view as the user types. Up/Down pick a result, Enter
+// selects it in the view and Esc leaves the selection unchanged.
+static void search_tasks(AppState *app) {
+  extern WINDOW *content_win;
+  app_sync_writes(app); // The search reads from the database
+
+  int scope = (app->current_view == VIEW_MAIN) ? 0 : 1;
+  TaskList results;
+  task_list_init(&results);
+  wchar_t query[SEARCH_MAX_QUERY] = L"";
+  char mb_query[SEARCH_MAX_QUERY * 4] = "";
+  int len = 0, selection = 0, scroll = 0;
+  bool stale = false, searching = true;
+
+  curs_set(1);
+  while (searching) {
+    if (stale) {
+      wcstombs(mb_query, query, sizeof(mb_query));
+      if (database_search_tasks(&app->db, mb_query, scope,
+                                SEARCH_RESULT_LIMIT, &results) != ORDO_OK)
+        task_list_clear(&results);
+      selection = scroll = 0;
+      stale = false;
+    }
+
+    int height = getmaxy(content_win) - 2;
+    if (selection < scroll)
+      scroll = selection;
+    if (selection >= scroll + height)
+      scroll = selection - height + 1;
+    ui_display_tasks(content_win, &results, &app->marks, &app->config, scroll,
+                     selection, app->current_view);
+    ui_display_search_prompt(mb_query, results.count, &app->config);
+    doupdate();
+
+    wint_t ch;
+    int type = get_wch(&ch);
+    if (type == KEY_CODE_YES) {
+      switch (ch) {
+      case KEY_ENTER:
+        choose_search_result(app, &results, selection);
+        searching = false;
+        break;
+      case KEY_UP:
+        if (selection > 0)
+          selection--;
+        break;
+      case KEY_DOWN:
+        if (selection + 1 < results.count)
+          selection++;
+        break;
+      case KEY_BACKSPACE:
+        if (len > 0) {
+          query[--len] = L'\0';
+          stale = true;
+        }
+        break;
+      case KEY_RESIZE:
+#ifdef _WIN32
+        resize_term(0, 0);
+#endif
+        ui_draw_layout();
+        break;
+      }
+    } else if (type == OK) {
+      if (ch == 27) { // Esc
+        searching = false;
+      } else if (ch == '\n') {
+        choose_search_result(app, &results, selection);
+        searching = false;
+      } else if (ch == 127 || ch == 8) { // Backspace
+        if (len > 0) {
+          query[--len] = L'\0';
+          stale = true;
+        }
+      } else if (iswprint(ch) && len < SEARCH_MAX_QUERY - 1) {
+        query[len++] = (wchar_t)ch;
+        query[len] = L'\0';
+        stale = true;
+      }
+    } // ERR: nothing was read
+  }
+  curs_set(0);
+  task_list_free(&results);
+  ui_clear_message();
+}
+
 // Handles user input in the main view
 static void handle_main_view_input(AppState *app, int choice) {
   OrdoResult result = ORDO_OK;
-  int task_id = (app->task_list.count > 0)
-                    ? app->task_list.tasks[app->current_selection].id
-                    : -1;
+  const Task *selected =
+      task_list_at(&app->task_list, app->current_selection);
+  int task_id = selected ? selected->id : -1;
 
   if (choice != 'u' && choice != 'y') {
     undo_manager_clear_redo(&app->undo_manager);
@@ -77,12 +271,13 @@ static void handle_main_view_input(AppState *app, int choice) {
     if (result == ORDO_OK) {
       if (ui_confirm_action("CONFIRM_ADD_PROMPT", "MENU_ADD", &app->config)) {
         int new_id = -1;
-        result = database_add_task(&app->db, new_desc, &new_id);
+        unsigned long seq = 0;
+        result = writer_add_task(&app->writer, new_desc, &new_id,
+                                 &app->task_list, &seq);
         if (result == ORDO_OK) {
           undo_manager_push(&app->undo_manager, ACTION_ADD, new_id, NULL, NULL,
-                            0);
+                            0, seq);
           handle_result(ORDO_ADD_SUCCESS, app);
-          app->refresh_tasks = true;
         } else {
           handle_result(result, app);
         }
@@ -93,19 +288,22 @@ static void handle_main_view_input(AppState *app, int choice) {
     break;
   }
   case '2': { // Mover para a Lixeira
-    if (task_id != -1) {
+    if (app->marks.count > 0) {
+      trash_marked(app);
+    } else if (task_id != -1) {
       if (ui_confirm_action("CONFIRM_TRASH_PROMPT", "MENU_REMOVE",
                             &app->config)) {
-        Task *task = &app->task_list.tasks[app->current_selection];
-        undo_manager_push(&app->undo_manager, ACTION_DELETE, task_id,
-                          task->descricao, NULL, task->concluida);
-        result = database_remove_task(&app->db, task_id);
+        // Keep the task for the undo history, the cached task is patched
+        // in place.
+        Task removed = *selected;
+        unsigned long seq = 0;
+        result = writer_remove_tasks(&app->writer, &task_id, 1,
+                                     &app->task_list, &seq);
         if (result == ORDO_OK) {
+          undo_manager_push(&app->undo_manager, ACTION_DELETE, task_id,
+                            removed.descricao, NULL, removed.concluida, seq);
           handle_result(ORDO_TRASH_SUCCESS, app);
-          app->refresh_tasks = true;
         } else {
-          // The action failed, so we remove it from the undo history
-          app->undo_manager.undo_top--;
           handle_result(result, app);
         }
       }
@@ -119,15 +317,16 @@ static void handle_main_view_input(AppState *app, int choice) {
       if (result == ORDO_OK) {
         if (ui_confirm_action("CONFIRM_EDIT_PROMPT", "MENU_EDIT",
                               &app->config)) {
-          result =
-              database_update_task_description(&app->db, task_id, new_desc);
+          // The cached task is patched in place, but its old description
+          // stays in the list's arena until the next reload.
+          const char *old_desc = selected->descricao;
+          unsigned long seq = 0;
+          result = writer_update_task_description(
+              &app->writer, task_id, new_desc, &app->task_list, &seq);
           if (result == ORDO_OK) {
-            undo_manager_push(
-                &app->undo_manager, ACTION_EDIT, task_id,
-                app->task_list.tasks[app->current_selection].descricao,
-                new_desc, 0);
+            undo_manager_push(&app->undo_manager, ACTION_EDIT, task_id,
+                              old_desc, new_desc, 0, seq);
             handle_result(ORDO_EDIT_SUCCESS, app);
-            app->refresh_tasks = true;
           } else {
             handle_result(result, app);
           }
@@ -139,21 +338,23 @@ static void handle_main_view_input(AppState *app, int choice) {
     break;
   }
   case '4': { // Marcar como Concluída/Pendente
-    if (task_id != -1) {
+    if (app->marks.count > 0) {
+      toggle_marked(app);
+    } else if (task_id != -1) {
       if (ui_confirm_action("CONFIRM_TOGGLE_PROMPT", "MENU_TOGGLE",
                             &app->config)) {
-        Task *task = &app->task_list.tasks[app->current_selection];
-        undo_manager_push(&app->undo_manager, ACTION_TOGGLE, task_id, NULL,
-                          NULL, task->concluida);
-        result =
-            database_toggle_task_status(&app->db, task_id, task->concluida);
+        int old_status = selected->concluida;
+        unsigned long seq = 0;
+        result = writer_toggle_tasks_status(&app->writer, &task_id,
+                                            &old_status, 1, &app->task_list,
+                                            &seq);
         if (result == ORDO_OK) {
-          app->refresh_tasks = true;
-          OrdoResult msg = task->concluida ? ORDO_TOGGLE_SUCCESS_REOPEN
-                                           : ORDO_TOGGLE_SUCCESS_DONE;
+          undo_manager_push(&app->undo_manager, ACTION_TOGGLE, task_id, NULL,
+                            NULL, old_status, seq);
+          OrdoResult msg = old_status ? ORDO_TOGGLE_SUCCESS_REOPEN
+                                      : ORDO_TOGGLE_SUCCESS_DONE;
           handle_result(msg, app);
         } else {
-          app->undo_manager.undo_top--;
           handle_result(result, app);
         }
       }
@@ -162,17 +363,19 @@ static void handle_main_view_input(AppState *app, int choice) {
   }
   case '5':
     if (task_id != -1)
-      ui_display_full_task(&app->task_list.tasks[app->current_selection],
-                           &app->config);
+      ui_display_full_task(selected, &app->config);
     break;
   case '6':
     settings_ui_show(&app->config);
-    app->refresh_tasks = true;
+    ui_invalidate(UI_REGION_ALL); // Language or colors may have changed
+    break;
+  case 'm':
+  case ' ': // Selecionar para ação em lote
+    toggle_mark(app, selected);
     break;
   case 'u': { // Desfazer
     if (undo_manager_perform_undo(&app->undo_manager, app)) {
       handle_result(ORDO_UNDO_SUCCESS, app);
-      app->refresh_tasks = true;
     } else {
       handle_result(ORDO_UNDO_FAILURE, app);
     }
@@ -181,7 +384,6 @@ static void handle_main_view_input(AppState *app, int choice) {
   case 'y': { // Refazer
     if (undo_manager_perform_redo(&app->undo_manager, app)) {
       handle_result(ORDO_REDO_SUCCESS, app);
-      app->refresh_tasks = true;
     } else {
       handle_result(ORDO_REDO_FAILURE, app);
     }
@@ -193,16 +395,26 @@ static void handle_main_view_input(AppState *app, int choice) {
 // Handles user input in the trash view
 static void handle_trash_view_input(AppState *app, int choice) {
   OrdoResult result = ORDO_OK;
-  if (app->task_list.count <= 0) return;
+  const Task *selected =
+      task_list_at(&app->task_list, app->current_selection);
+  if (!selected) return;
 
-  int task_id = app->task_list.tasks[app->current_selection].id;
+  int task_id = selected->id;
 
   switch (choice) {
   case 'r': // Restaurar
-    result = database_restore_task(&app->db, task_id);
+    if (app->marks.count > 0) {
+      unsigned long seq = 0;
+      result = writer_restore_tasks(&app->writer, app->marks.ids,
+                                    app->marks.count, &app->task_list, &seq);
+      if (result == ORDO_OK)
+        app_hold_marks(app, seq);
+    } else {
+      result = writer_restore_tasks(&app->writer, &task_id, 1,
+                                    &app->task_list, NULL);
+    }
     if (result == ORDO_OK) {
       handle_result(ORDO_RESTORE_SUCCESS, app);
-      app->refresh_tasks = true;
     } else {
       handle_result(result, app);
     }
@@ -210,15 +422,28 @@ static void handle_trash_view_input(AppState *app, int choice) {
   case 'd': // Deletar Permanentemente
     if (ui_confirm_action("CONFIRM_PERM_DELETE_PROMPT", "MENU_PERM_DELETE",
                           &app->config)) {
-      result = database_permanently_delete_task(&app->db, task_id);
+      if (app->marks.count > 0) {
+        unsigned long seq = 0;
+        result = writer_permanently_delete_tasks(
+            &app->writer, app->marks.ids, app->marks.count, &app->task_list,
+            &seq);
+        if (result == ORDO_OK)
+          app_hold_marks(app, seq);
+      } else {
+        result = writer_permanently_delete_tasks(&app->writer, &task_id, 1,
+                                                 &app->task_list, NULL);
+      }
       if (result == ORDO_OK) {
         handle_result(ORDO_PERM_DELETE_SUCCESS, app);
-        app->refresh_tasks = true;
       } else {
         handle_result(result, app);
       }
     }
     break;
+  case 'm':
+  case ' ': // Selecionar para ação em lote
+    toggle_mark(app, selected);
+    break;
   }
 }
 
@@ -229,9 +454,86 @@ static void handle_trash_view_input(AppState *app, int choice) {
 // Groups all possible events for scroll down (Button 5)
 #define SCROLL_DOWN_EVENTS (BUTTON5_PRESSED | BUTTON5_RELEASED | BUTTON5_CLICKED | BUTTON5_DOUBLE_CLICKED | BUTTON5_TRIPLE_CLICKED)
 
+// Moves the selection, or the view for the mouse wheel. Returns false for a
+// key that does something else. Each key is O(1); the rows are only loaded
+// and drawn once the whole run of keys is handled.
+static bool navigate(AppState *app, int key, const MEVENT *mouse) {
+  extern WINDOW *content_win;
+  int total = task_list_total(&app->task_list);
+  int height = getmaxy(content_win) - 2;
+  if (height < 1)
+    height = 1;
+
+  switch (key) {
+  case KEY_UP:
+    if (total > 0)
+      app->current_selection =
+          (app->current_selection - 1 + total) % total;
+    return true;
+  case KEY_DOWN:
+    if (total > 0)
+      app->current_selection = (app->current_selection + 1) % total;
+    return true;
+  case KEY_PPAGE:
+  case KEY_NPAGE: {
+    // The page moves along with the selection, which keeps its row.
+    int step = key == KEY_NPAGE ? height : -height;
+    int last_offset = total > height ? total - height : 0;
+    app->scroll_offset += step;
+    if (app->scroll_offset > last_offset)
+      app->scroll_offset = last_offset;
+    if (app->scroll_offset < 0)
+      app->scroll_offset = 0;
+    app->current_selection += step;
+    if (app->current_selection >= total)
+      app->current_selection = total - 1;
+    if (app->current_selection < 0)
+      app->current_selection = 0;
+    return true;
+  }
+  case KEY_HOME:
+    app->current_selection = 0;
+    return true;
+  case KEY_END:
+    app->current_selection = total > 0 ? total - 1 : 0;
+    return true;
+  case KEY_MOUSE:
+    if (!mouse || !wenclose(content_win, mouse->y, mouse->x))
+      return false;
+    if (mouse->bstate & SCROLL_UP_EVENTS) {
+      if (app->scroll_offset > 0)
+        app->scroll_offset--;
+    } else if (mouse->bstate & SCROLL_DOWN_EVENTS) {
+      if (app->scroll_offset + height < total)
+        app->scroll_offset++;
+    } else {
+      return false;
+    }
+    // Drag the selection along, or the view would snap back to it.
+    if (app->current_selection < app->scroll_offset)
+      app->current_selection = app->scroll_offset;
+    if (app->current_selection >= app->scroll_offset + height)
+      app->current_selection = app->scroll_offset + height - 1;
+    return true;
+  }
+  return false;
+}
+
 // Main function that processes all keyboard and mouse input
 void input_handle(AppState *app, int key) {
-  if (key == ERR) { // Timeout, nenhuma tecla pressionada
+  // Typeahead: the keys typed while the last frame was drawn are all handled
+  // before the next one, so a held arrow key or a spun mouse wheel costs one
+  // frame per batch rather than one per key. The first key that does more
+  // than move around ends the batch.
+  MEVENT mouse;
+  bool have_mouse = false;
+  while (key != ERR) {
+    have_mouse = key == KEY_MOUSE && getmouse(&mouse) == OK;
+    if (!navigate(app, key, have_mouse ? &mouse : NULL))
+      break;
+    key = event_loop_poll_key(&app->events);
+  }
+  if (key == ERR) { // Nenhuma tecla pressionada
     return;
   }
 
@@ -240,6 +542,8 @@ void input_handle(AppState *app, int key) {
     if (app->current_view == VIEW_TRASH) {
       app->current_view = VIEW_MAIN;
       app->refresh_tasks = true;
+      task_marks_clear(&app->marks);
+      task_marks_clear(&app->held_marks);
     } else {
       app->should_exit = true;
     }
@@ -249,19 +553,8 @@ void input_handle(AppState *app, int key) {
     app->current_view =
         (app->current_view == VIEW_MAIN) ? VIEW_TRASH : VIEW_MAIN;
     app->refresh_tasks = true;
-    return;
-  }
-  if (key == KEY_UP) {
-    if (app->task_list.count > 0)
-      app->current_selection =
-          (app->current_selection - 1 + app->task_list.count) %
-          app->task_list.count;
-    return;
-  }
-  if (key == KEY_DOWN) {
-    if (app->task_list.count > 0)
-      app->current_selection =
-          (app->current_selection + 1) % app->task_list.count;
+    task_marks_clear(&app->marks);
+    task_marks_clear(&app->held_marks);
     return;
   }
   if (key == KEY_RESIZE) {
@@ -269,46 +562,51 @@ void input_handle(AppState *app, int key) {
     // PDCurses handles resizing differently.
     // A KEY_RESIZE event is sent, and we just need to call resize_term.
     resize_term(0, 0);
-#else
-    // For ncurses, we check if the size has actually changed
-    // before redrawing everything.
-    resizeterm(LINES, COLS);
 #endif
-    app->refresh_tasks = true; // Force a redraw
+    // ncurses resizes stdscr before it reports KEY_RESIZE. Calling
+    // resizeterm() again would queue another KEY_RESIZE, endlessly.
+    return; // The next loop iteration redraws the layout
+  }
+  if (key == KEY_F(5)) { // Explicit resync with the database
+    app->refresh_tasks = true;
     return;
   }
-  if (key == KEY_MOUSE) {
-    MEVENT event;
-    if (getmouse(&event) == OK) {
-      extern WINDOW *content_win, *sidebar_win;
-      if (wenclose(content_win, event.y, event.x)) {
-        if (event.bstate & SCROLL_UP_EVENTS) { // Scroll up
-          if (app->scroll_offset > 0)
-            app->scroll_offset--;
-        } else if (event.bstate & SCROLL_DOWN_EVENTS) { // Scroll down
-          int height = getmaxy(content_win) - 2;
-          if (app->scroll_offset + height < app->task_list.count)
-            app->scroll_offset++;
-        } else if (event.bstate & (BUTTON1_CLICKED | BUTTON1_DOUBLE_CLICKED)) {
-          int clicked_y = event.y - getbegy(content_win) - 1;
-          if (clicked_y >= 0) {
-            int clicked_task = clicked_y + app->scroll_offset;
-            if (clicked_task < app->task_list.count) {
-              app->current_selection = clicked_task;
-              if (event.bstate & BUTTON1_DOUBLE_CLICKED) {
-                ui_display_full_task(
-                    &app->task_list.tasks[app->current_selection],
-                    &app->config);
-              }
+  if (key == KEY_F(12)) { // Performance overlay
+    perf_set_enabled(!perf_enabled());
+    return;
+  }
+  if (key == KEY_MOUSE && have_mouse) {
+    extern WINDOW *content_win, *sidebar_win;
+    int total = task_list_total(&app->task_list);
+    if (wenclose(content_win, mouse.y, mouse.x)) {
+      if (mouse.bstate & (BUTTON1_CLICKED | BUTTON1_DOUBLE_CLICKED)) {
+        int clicked_y = mouse.y - getbegy(content_win) - 1;
+        if (clicked_y >= 0) {
+          int clicked_task = clicked_y + app->scroll_offset;
+          if (clicked_task < total) {
+            app->current_selection = clicked_task;
+            const Task *clicked =
+                task_list_at(&app->task_list, clicked_task);
+            if (clicked && (mouse.bstate & BUTTON1_DOUBLE_CLICKED)) {
+              ui_display_full_task(clicked, &app->config);
             }
           }
         }
-      } else if (wenclose(sidebar_win, event.y, event.x)) {
-        key = ui_handle_sidebar_click(event, app->current_view);
       }
+    } else if (wenclose(sidebar_win, mouse.y, mouse.x)) {
+      key = ui_handle_sidebar_click(mouse, app->current_view);
     }
   }
 
+  if (key == '/') { // Pesquisar
+    search_tasks(app);
+    return;
+  }
+  if (key == 'f') { // Alternar filtro/ordenacao
+    cycle_list_view(app);
+    return;
+  }
+
   // View-specific actions
   if (app->current_view == VIEW_MAIN) {
     handle_main_view_input(app, key);
@@ -1,10 +1,18 @@
 #include "app.h"
+#include "event_loop.h"
 #include "input.h"
+#include "perf_stats.h"
 #include "ui.h"
+#include "utils.h"
 #include <ncurses.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+// How often to poll for acknowledgements while the writer thread has work in
+// flight, if it cannot wake the event loop itself
+#define WRITE_ACK_POLL_MS 20
+
 // Function to update the screen scrolling logic
 static void update_scroll(AppState *app) {
   extern WINDOW *content_win;
@@ -16,29 +24,53 @@ static void update_scroll(AppState *app) {
   if (app->current_selection >= app->scroll_offset + content_height) {
     app->scroll_offset = app->current_selection - content_height + 1;
   }
+
+  // In windowed mode, make sure the visible rows are in memory. Reading
+  // requires the queued writes to be in the database first.
+  if (!task_list_covers(&app->task_list, app->scroll_offset, content_height)) {
+    app_sync_writes(app);
+    database_load_window(&app->db, &app->task_list, app->scroll_offset,
+                         content_height);
+  }
 }
 
-// Function to redraw the entire interface
+// Function to redraw the interface. Each part repaints only what changed
+// since the previous frame.
 static void redraw_ui(AppState *app) {
   extern WINDOW *sidebar_win, *content_win;
 
   ui_draw_layout();
   ui_display_menu(sidebar_win, &app->config, app->current_view);
-  ui_display_tasks(content_win, app->task_list.tasks, app->task_list.count,
-                   &app->config, app->scroll_offset, app->current_selection,
+  ui_display_tasks(content_win, &app->task_list, &app->marks, &app->config,
+                   app->scroll_offset, app->current_selection,
                    app->current_view);
 
-  // Display the clock
-  time_t now = time(NULL);
-  struct tm *local_time = localtime(&now);
+  // Display the clock. time() may lag the clock the minute timer runs on by
+  // a few milliseconds, and would still read the previous minute.
+  struct timespec now;
+  timespec_get(&now, TIME_UTC);
+  struct tm *local_time = localtime(&now.tv_sec);
   char time_str[6];
   strftime(time_str, sizeof(time_str), "%H:%M", local_time);
   ui_display_clock(sidebar_win, time_str);
 
+  // The numbers are those of the previous frame; this one is not over yet.
+  PerfStats stats;
+  if (perf_enabled())
+    perf_stats(&stats);
+  ui_display_perf_overlay(perf_enabled() ? &stats : NULL, &app->config);
+
   doupdate();
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--db-info") == 0) {
+    return app_print_db_info();
+  }
+  if (argc > 1 && strcmp(argv[1], "--compact") == 0) {
+    return app_compact_db();
+  }
+
   AppState app;
   if (!app_init(&app)) {
     fprintf(stderr, "Failed to initialize the application.\n");
@@ -46,7 +78,15 @@ int main() {
   }
 
   while (!app.should_exit) {
+    perf_frame_begin();
+    app_process_write_acks(&app);
+    // Positions shift when tasks come and go; the selection follows its task.
+    int selected_id = app_selected_task_id(&app);
+
+    // Mutations patch the task list in place; a full reload only happens when
+    // the view changes, a write fails or a resync is requested.
     if (app.refresh_tasks) {
+      app_sync_writes(&app);
       task_list_clear(&app.task_list);
       if (app.current_view == VIEW_MAIN) {
         database_load_tasks(&app.db, &app.task_list);
@@ -54,16 +94,32 @@ int main() {
         database_load_deleted_tasks(&app.db, &app.task_list);
       }
       app.refresh_tasks = false;
-      if (app.current_selection >= app.task_list.count) {
-        app.current_selection =
-            app.task_list.count > 0 ? app.task_list.count - 1 : 0;
-      }
+    } else {
+      // Pick up what other instances sharing the database have written.
+      app_sync_external_changes(&app);
+    }
+    app_select_task(&app, selected_id);
+    int total = task_list_total(&app.task_list);
+    if (app.current_selection >= total) {
+      app.current_selection = total > 0 ? total - 1 : 0;
     }
 
     update_scroll(&app);
     redraw_ui(&app);
+    perf_frame_end();
 
-    int key = getch();
+    // Sleep until a key is typed, the clock needs a new minute, the writer
+    // acknowledges a mutation or another instance commits.
+    int max_wait = writer_event_fd(&app.writer) < 0 && writer_busy(&app.writer)
+                       ? WRITE_ACK_POLL_MS
+                       : -1;
+    int key;
+    unsigned int events = event_loop_wait(&app.events, max_wait, &key);
+    if (events & EVENT_INPUT) {
+      ui_clear_message(); // A message stays up until the next key
+    } else {
+      app_run_maintenance(&app); // Nothing typed: use the idle time
+    }
     input_handle(&app, key);
   }
 
@@ -0,0 +1,252 @@
+// ordo-bench - Times the drawing of the interface on a virtual screen.
+//
+// Draws frames of a synthetic task list with the same functions the app uses,
+// headless, and reports the time per frame and the bytes that would have been
+// sent to the terminal. With --snapshot it prints one frame as text instead,
+// to compare against a saved one.
+
+#include "i18n.h"
+#include "task_list.h"
+#include "task_marks.h"
+#include "ui.h"
+#include "utils.h"
+#include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_LINES 40
+#define DEFAULT_COLS 120
+#define DEFAULT_TASKS 2000
+#define DEFAULT_FRAMES 500
+
+// Mixes the scripts and widths found in real lists: accents, CJK, emoji
+static const char *const samples[] = {
+    "Review the quarterly report before the meeting",
+    "Comprar pão, café e açúcar",
+    "会議の資料を準備する",
+    "Fix the \U0001F41B in the parser \U0001F680",
+    "Позвонить в банк",
+    "Plan the trip \U0001F1EF\U0001F1F5 with the family "
+    "\U0001F468\u200D\U0001F469\u200D\U0001F467"};
+#define SAMPLE_COUNT (int)(sizeof(samples) / sizeof(samples[0]))
+
+typedef struct {
+  AppConfig config;
+  TaskList list;
+  TaskMarks marks;
+  FILE *sink;
+  int scroll_offset;
+  int selection;
+} Bench;
+
+typedef struct {
+  const char *name;
+  void (*step)(Bench *bench, int frame);
+} Scenario;
+
+static double now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+// Bytes written to the sink so far
+static long sink_size(FILE *sink) {
+  fflush(sink);
+  fseek(sink, 0, SEEK_END);
+  return ftell(sink);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Fills the list with `count` tasks; every tenth is a long note and every
+// seventh is marked.
+static bool fill_tasks(Bench *bench, int count) {
+  char description[1024];
+  for (int i = 0; i < count; i++) {
+    int len = safe_snprintf(description, sizeof(description), "%s #%d",
+                            samples[i % SAMPLE_COUNT], i);
+    for (int j = 1; i % 10 == 0 && j < 6; j++)
+      len += safe_snprintf(description + len, sizeof(description) - (size_t)len,
+                           " %s", samples[(i + j) % SAMPLE_COUNT]);
+    Task task = {.id = i + 1, .descricao = description, .concluida = i % 3 == 0};
+    if (!task_list_add(&bench->list, &task))
+      return false;
+    if (i % 7 == 0)
+      task_marks_toggle(&bench->marks, &task);
+  }
+  return true;
+}
+
+// Draws a frame as the main loop does, with a fixed clock.
+static void draw_frame(Bench *bench) {
+  extern WINDOW *sidebar_win, *content_win;
+
+  ui_draw_layout();
+  ui_display_menu(sidebar_win, &bench->config, VIEW_MAIN);
+  ui_display_tasks(content_win, &bench->list, &bench->marks, &bench->config,
+                   bench->scroll_offset, bench->selection, VIEW_MAIN);
+  ui_display_clock(sidebar_win, "12:00");
+  doupdate();
+}
+
+// Moves the selection and keeps it on screen, as the main loop does.
+static void select_task(Bench *bench, int selection) {
+  extern WINDOW *content_win;
+  int rows = getmaxy(content_win) - 2;
+  bench->selection = selection;
+  if (selection < bench->scroll_offset)
+    bench->scroll_offset = selection;
+  if (selection >= bench->scroll_offset + rows)
+    bench->scroll_offset = selection - rows + 1;
+}
+
+static void step_full(Bench *bench, int frame) {
+  (void)frame;
+  ui_invalidate(UI_REGION_ALL);
+  draw_frame(bench);
+}
+
+static void step_idle(Bench *bench, int frame) {
+  (void)frame;
+  draw_frame(bench);
+}
+
+static void step_scroll(Bench *bench, int frame) {
+  select_task(bench, frame % task_list_total(&bench->list));
+  draw_frame(bench);
+}
+
+static void step_page(Bench *bench, int frame) {
+  extern WINDOW *content_win;
+  int rows = getmaxy(content_win) - 2;
+  select_task(bench, frame * rows % task_list_total(&bench->list));
+  draw_frame(bench);
+}
+
+static void step_confirm(Bench *bench, int frame) {
+  (void)frame;
+  ungetch('n');
+  ui_confirm_action("CONFIRM_TRASH_PROMPT", "MENU_REMOVE", &bench->config);
+  draw_frame(bench);
+}
+
+static void step_full_task(Bench *bench, int frame) {
+  ungetch('q');
+  // The long notes, every tenth task
+  int position = frame % 10 * 10 % task_list_total(&bench->list);
+  ui_display_full_task(task_list_at(&bench->list, position), &bench->config);
+  draw_frame(bench);
+}
+
+static const Scenario scenarios[] = {
+    {"full redraw", step_full},
+    {"idle", step_idle},
+    {"scroll by row", step_scroll},
+    {"scroll by page", step_page},
+    {"confirm popup", step_confirm},
+    {"full task view", step_full_task}};
+
+static void run_scenario(Bench *bench, const Scenario *scenario, int frames,
+                         double *times) {
+  bench->scroll_offset = bench->selection = 0;
+  ui_invalidate(UI_REGION_ALL);
+  draw_frame(bench);
+
+  long bytes = sink_size(bench->sink);
+  double total = 0;
+  for (int i = 0; i < frames; i++) {
+    double start = now_us();
+    scenario->step(bench, i + 1);
+    times[i] = now_us() - start;
+    total += times[i];
+  }
+  bytes = sink_size(bench->sink) - bytes;
+
+  qsort(times, (size_t)frames, sizeof(double), compare_doubles);
+  printf("%-16s %10.1f %10.1f %10.1f %12.0f\n", scenario->name,
+         total / frames, times[frames / 2], times[(frames - 1) * 99 / 100],
+         (double)bytes / frames);
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [--size LINESxCOLS] [--tasks N] [--frames N] "
+          "[--snapshot]\n",
+          program);
+}
+
+int main(int argc, char *argv[]) {
+  int lines = DEFAULT_LINES, cols = DEFAULT_COLS;
+  int task_count = DEFAULT_TASKS, frames = DEFAULT_FRAMES;
+  bool snapshot = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%dx%d", &lines, &cols) != 2)
+        lines = 0;
+    } else if (strcmp(argv[i], "--tasks") == 0 && i + 1 < argc) {
+      task_count = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--snapshot") == 0) {
+      snapshot = true;
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (lines < 10 || cols < 60 || task_count < 1 || frames < 1) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  // The widths of the samples are only right in a UTF-8 locale.
+  if (!setlocale(LC_ALL, "C.UTF-8"))
+    setlocale(LC_ALL, "");
+
+  Bench bench = {0};
+  set_default_config(&bench.config);
+  i18n_init(bench.config.lang);
+  task_list_init(&bench.list);
+  task_marks_init(&bench.marks);
+  bench.sink = tmpfile();
+  double *times = malloc(sizeof(double) * (size_t)frames);
+  int status = 1;
+  if (!bench.sink || !times || !fill_tasks(&bench, task_count)) {
+    fprintf(stderr, "Out of memory.\n");
+  } else if (!ui_init_headless(&bench.config, lines, cols, bench.sink)) {
+    fprintf(stderr, "No terminal description found for the virtual screen.\n");
+  } else {
+    if (snapshot) {
+      draw_frame(&bench);
+      char *text = ui_snapshot();
+      if (text) {
+        fputs(text, stdout);
+        free(text);
+        status = 0;
+      }
+    } else {
+      printf("%dx%d, %d tasks, %d frames\n\n", lines, cols, task_count,
+             frames);
+      printf("%-16s %10s %10s %10s %12s\n", "scenario", "mean us", "p50 us",
+             "p99 us", "bytes/frame");
+      for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+        run_scenario(&bench, &scenarios[i], frames, times);
+      status = 0;
+    }
+    ui_destroy();
+  }
+
+  free(times);
+  if (bench.sink)
+    fclose(bench.sink);
+  task_list_free(&bench.list);
+  task_marks_free(&bench.marks);
+  i18n_destroy();
+  return status;
+}
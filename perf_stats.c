@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+#include "perf_stats.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define FRAME_HISTORY 256 // Frames the percentile is taken over
+
+static uint64_t frame_times[FRAME_HISTORY];
+static int frame_count; // Frames recorded, ever
+static uint64_t frame_start;
+static unsigned long frame_start_allocations;
+static long frame_start_bytes = -1;
+
+static PerfStats last; // The database timings, and the last frame's counts
+static bool enabled;
+
+// --- Heap Allocations ---
+
+// Counted per thread, so the writer thread's allocations stay out of the
+// UI thread's frames.
+static _Thread_local unsigned long thread_allocations;
+
+void *ordo_malloc(size_t size) {
+  thread_allocations++;
+  return malloc(size);
+}
+
+void *ordo_calloc(size_t count, size_t size) {
+  thread_allocations++;
+  return calloc(count, size);
+}
+
+void *ordo_realloc(void *ptr, size_t size) {
+  thread_allocations++;
+  return realloc(ptr, size);
+}
+
+char *ordo_strdup(const char *str) {
+  size_t size = strlen(str) + 1;
+  char *copy = ordo_malloc(size);
+  return copy ? memcpy(copy, str, size) : NULL;
+}
+
+// --- Terminal Output ---
+
+// The bytes the calling thread has written so far, or -1 if unknown. The UI
+// thread writes nothing but the terminal output; the database is written by
+// the writer thread.
+static long written_bytes(void) {
+#ifdef __linux__
+  int fd = open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  char buffer[512];
+  ssize_t len = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (len <= 0)
+    return -1;
+  buffer[len] = '\0';
+  const char *field = strstr(buffer, "wchar:");
+  return field ? strtol(field + strlen("wchar:"), NULL, 10) : -1;
+#else
+  return -1;
+#endif
+}
+
+uint64_t perf_now(void) {
+  struct timespec now;
+#ifdef _WIN32
+  timespec_get(&now, TIME_UTC);
+#else
+  clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+  return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+void perf_db_record(PerfDbCall call, uint64_t start, int rows) {
+  last.db[call] = (PerfDbTiming){perf_now() - start, rows, true};
+}
+
+void perf_frame_begin(void) {
+  frame_start_bytes = enabled ? written_bytes() : -1;
+  frame_start_allocations = thread_allocations;
+  frame_start = perf_now();
+}
+
+void perf_frame_end(void) {
+  uint64_t end = perf_now();
+  last.allocations = thread_allocations - frame_start_allocations;
+  long bytes = frame_start_bytes >= 0 ? written_bytes() : -1;
+  last.tty_bytes = bytes >= 0 ? bytes - frame_start_bytes : -1;
+  last.frame_ns = end - frame_start;
+  frame_times[frame_count++ % FRAME_HISTORY] = last.frame_ns;
+}
+
+void perf_set_enabled(bool enable) { enabled = enable; }
+
+bool perf_enabled(void) { return enabled; }
+
+// The 99th percentile of the recorded frames. Only the few slowest frames
+// matter, so they are kept while scanning instead of sorting all of them.
+static uint64_t frame_percentile_99(void) {
+  int count = frame_count < FRAME_HISTORY ? frame_count : FRAME_HISTORY;
+  if (count == 0)
+    return 0;
+  int rank = count - (count - 1) * 99 / 100; // 1 is the slowest
+  uint64_t slowest[FRAME_HISTORY / 100 + 2] = {0}; // Slowest first
+  for (int i = 0; i < count; i++) {
+    uint64_t time = frame_times[i];
+    int j = rank - 1;
+    if (time <= slowest[j])
+      continue;
+    for (; j > 0 && slowest[j - 1] < time; j--)
+      slowest[j] = slowest[j - 1];
+    slowest[j] = time;
+  }
+  return slowest[rank - 1];
+}
+
+void perf_stats(PerfStats *stats) {
+  *stats = last;
+  stats->frame_p99_ns = frame_percentile_99();
+}
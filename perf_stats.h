@@ -0,0 +1,136 @@
+/**
+ * @file perf_stats.h
+ * @brief Lightweight counters of where the time of a frame goes, for the
+ * performance overlay.
+ *
+ * A frame is one pass of the main loop from waking up to `doupdate`: picking
+ * up acknowledgements and changes, reloading, and redrawing. Waiting for a key
+ * and the dialogs a key opens are not part of it. The last frames' durations
+ * are kept to report the latest one and the 99th percentile.
+ *
+ * The read paths of the database record the duration and the rows of their
+ * last call. The code that runs every frame (the task list, the rendering
+ * helpers and the UI's caches) allocates through `ordo_malloc` and its
+ * siblings, which count the allocations of the calling thread; allocations by
+ * libraries are not counted. The bytes the UI thread writes to the terminal
+ * are read from `/proc` on Linux; elsewhere they are reported as unknown.
+ *
+ * Recording costs a clock read per frame and per database call, and an
+ * increment per allocation. Everything else is only done while the overlay is
+ * shown. Not thread-safe, apart from the allocation functions: UI thread only.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @enum PerfDbCall
+ * @brief The database calls made on the UI thread.
+ */
+typedef enum {
+  PERF_DB_LOAD,   /**< `database_load_tasks` */
+  PERF_DB_TRASH,  /**< `database_load_deleted_tasks` */
+  PERF_DB_WINDOW, /**< `database_load_window` */
+  PERF_DB_SYNC,   /**< `database_sync_changes` */
+  PERF_DB_SEARCH, /**< `database_search_tasks` */
+  PERF_DB_COUNT
+} PerfDbCall;
+
+/**
+ * @struct PerfDbTiming
+ * @brief The last call of a database function.
+ */
+typedef struct {
+  uint64_t ns;   /**< How long it took. */
+  int rows;      /**< The rows it read into the task list. */
+  bool called;   /**< Whether it was called at all. */
+} PerfDbTiming;
+
+/**
+ * @struct PerfStats
+ * @brief What the overlay shows.
+ */
+typedef struct {
+  uint64_t frame_ns;     /**< The duration of the last frame. */
+  uint64_t frame_p99_ns; /**< The 99th percentile of the last frames. */
+  PerfDbTiming db[PERF_DB_COUNT]; /**< The last call of each database function. */
+  unsigned long allocations; /**< Counted heap allocations during the last frame. */
+  long tty_bytes;        /**< Bytes written to the terminal during the last frame, or -1 if unknown. */
+} PerfStats;
+
+/**
+ * @brief Allocates memory like `malloc` and counts it for the calling thread.
+ * @param[in] size The number of bytes.
+ * @return The memory, to be released with `free`, or `NULL`.
+ */
+void *ordo_malloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory like `calloc` and counts it.
+ * @param[in] count The number of elements.
+ * @param[in] size The size of each element.
+ * @return The memory, to be released with `free`, or `NULL`.
+ */
+void *ordo_calloc(size_t count, size_t size);
+
+/**
+ * @brief Resizes memory like `realloc` and counts it.
+ * @param[in] ptr The memory to resize, or `NULL`.
+ * @param[in] size The new size in bytes.
+ * @return The resized memory, or `NULL` with `ptr` left untouched.
+ */
+void *ordo_realloc(void *ptr, size_t size);
+
+/**
+ * @brief Copies a string like `strdup` and counts the allocation.
+ * @param[in] str The string.
+ * @return The copy, to be released with `free`, or `NULL`.
+ */
+char *ordo_strdup(const char *str);
+
+/**
+ * @brief Returns a monotonic clock reading, in nanoseconds.
+ */
+uint64_t perf_now(void);
+
+/**
+ * @brief Records a database call.
+ * @param[in] call The function.
+ * @param[in] start What `perf_now` returned when it started.
+ * @param[in] rows The rows it read.
+ */
+void perf_db_record(PerfDbCall call, uint64_t start, int rows);
+
+/**
+ * @brief Marks the start of a frame.
+ */
+void perf_frame_begin(void);
+
+/**
+ * @brief Marks the end of a frame, once it was sent to the terminal.
+ */
+void perf_frame_end(void);
+
+/**
+ * @brief Shows or hides the overlay. The terminal output is only measured
+ * while it is shown.
+ * @param[in] enabled Whether it is shown.
+ */
+void perf_set_enabled(bool enabled);
+
+/**
+ * @brief Returns whether the overlay is shown.
+ */
+bool perf_enabled(void);
+
+/**
+ * @brief Collects the numbers of the frames recorded so far.
+ * @param[out] stats Receives them.
+ */
+void perf_stats(PerfStats *stats);
+
+#endif // PERF_STATS_H
@@ -104,10 +104,9 @@ static void ui_settings_select_theme(AppConfig *config) {
     }
     clear();
 
-    wchar_t wide_buffer[256];
     char truncated_buffer[256];
-    mbstowcs(wide_buffer, get_translation("SELECT_THEME_INSTRUCTIONS"), 256);
-    mvaddwstr(1, (COLS - wcswidth(wide_buffer, -1)) / 2, wide_buffer);
+    const char *instructions = get_translation("SELECT_THEME_INSTRUCTIONS");
+    mvaddstr(1, (COLS - str_width(instructions)) / 2, instructions);
 
     if (current_selection < scroll_offset)
       scroll_offset = current_selection;
@@ -247,9 +246,8 @@ static void ui_settings_select_language(AppConfig *config) {
 
   while (1) {
     clear();
-    wchar_t wide_buffer[256];
-    mbstowcs(wide_buffer, get_translation("SELECT_LANGUAGE_INSTRUCTIONS"), 256);
-    mvaddwstr(1, (COLS - wcswidth(wide_buffer, -1)) / 2, wide_buffer);
+    const char *instructions = get_translation("SELECT_LANGUAGE_INSTRUCTIONS");
+    mvaddstr(1, (COLS - str_width(instructions)) / 2, instructions);
 
     int list_start_y = (LINES - lang_count) / 2;
     if (list_start_y < 3)
@@ -312,10 +310,9 @@ void settings_ui_show(AppConfig *config) {
     box(win, 0, 0);
 
     // Title
-    wchar_t wide_buffer[256];
-    mbstowcs(wide_buffer, get_translation("SETTINGS_MENU"), 256);
+    const char *title = get_translation("SETTINGS_MENU");
     wattron(win, COLOR_PAIR(config->color_pair_header));
-    mvwaddwstr(win, 1, (win_w - wcswidth(wide_buffer, -1)) / 2, wide_buffer);
+    mvwaddstr(win, 1, (win_w - str_width(title)) / 2, title);
     wattroff(win, COLOR_PAIR(config->color_pair_header));
 
     // Options
@@ -333,8 +330,7 @@ void settings_ui_show(AppConfig *config) {
       char truncated_buffer[256];
       truncate_by_width(truncated_buffer, sizeof(truncated_buffer),
                           str_buffer, win_w - x * 2);
-      mbstowcs(wide_buffer, truncated_buffer, 256);
-      mvwaddwstr(win, y, x, wide_buffer);
+      mvwaddstr(win, y, x, truncated_buffer);
 
       if (i == current_selection) {
         wattroff(win, A_REVERSE);
@@ -4,11 +4,15 @@
 // Defines the structure of a task.
 // Used throughout the application to represent a single task.
 
-#define MAX_DESCRICAO 200
+// Longest description, in characters, accepted by the task editor. Stored
+// descriptions have no length limit.
+#define MAX_DESCRICAO 800
 
 typedef struct {
   int id;
-  char descricao[MAX_DESCRICAO];
+  // Not owned by the task: it points into the string arena of the `TaskList`
+  // holding it, or into the buffer the task was read from.
+  const char *descricao;
   int concluida;
   int is_deleted;
 } Task;
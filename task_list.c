@@ -1,65 +1,721 @@
 #include "task_list.h"
+#include "perf_stats.h"
 #include "utils.h"
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define INITIAL_CAPACITY 10
+// Size of the first arena chunk. Each new chunk doubles the previous one, up
+// to ARENA_MAX_CHUNK; a longer description gets a chunk of its own size.
+#define ARENA_MIN_CHUNK 4096
+#define ARENA_MAX_CHUNK (1 << 20)
+
+struct TaskListChunk {
+    TaskListChunk *next; // The previous (older) chunk
+    size_t size;         // Capacity of `data`, in bytes
+    size_t used;         // Bytes of `data` already handed out
+    char data[];
+};
+
+// Number of 64-bit words holding `n` bits.
+#define BIT_WORDS(n) (((n) + 63) / 64)
+
+// Tombstones are compacted away once more than 1/TOMBSTONE_SHARE of the
+// slots hold one.
+#define TOMBSTONE_SHARE 4
+
+// Smallest ID table; it grows so that at most half of its slots are in use.
+#define ID_TABLE_MIN_CAPACITY 16
+
+// Generations are drawn from one counter for every list, so that no two
+// lists, even on different threads, ever share one.
+static atomic_ulong next_generation = 1;
+
+struct TaskListSlot {
+    int id;    // The task ID
+    int index; // Its index in `tasks`, or -1 if the slot is empty
+};
 
 void task_list_init(TaskList *list) {
-    list->tasks = malloc(INITIAL_CAPACITY * sizeof(Task));
-    if (list->tasks == NULL) {
+    list->tasks = ordo_malloc(INITIAL_CAPACITY * sizeof(Task));
+    list->live_bits =
+        ordo_calloc(BIT_WORDS(INITIAL_CAPACITY), sizeof(uint64_t));
+    list->done_bits =
+        ordo_calloc(BIT_WORDS(INITIAL_CAPACITY), sizeof(uint64_t));
+    if (list->tasks == NULL || list->live_bits == NULL || list->done_bits == NULL) {
         // In a real-world application, more robust error handling would be needed,
         // such as returning an error code.
         exit(EXIT_FAILURE); 
     }
     list->count = 0;
+    list->slots = 0;
     list->capacity = INITIAL_CAPACITY;
+    list->deleted_scope = 0;
+    list->windowed = false;
+    list->window_start = 0;
+    list->total_count = 0;
+    list->arena = NULL;
+    list->id_table = NULL;
+    list->id_table_capacity = 0;
+    list->view = TASK_VIEW_ALL;
+    list->generation = atomic_fetch_add(&next_generation, 1);
+    memset(list->views, 0, sizeof(list->views));
+}
+
+// Frees a chain of arena chunks.
+static void free_chunks(TaskListChunk *chunk) {
+    while (chunk) {
+        TaskListChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
 }
 
 void task_list_free(TaskList *list) {
     if (list) {
+        free_chunks(list->arena);
+        list->arena = NULL;
+        free(list->id_table);
+        list->id_table = NULL;
+        list->id_table_capacity = 0;
+        task_view_free(list);
+        free(list->live_bits);
+        list->live_bits = NULL;
+        free(list->done_bits);
+        list->done_bits = NULL;
         free(list->tasks);
         list->tasks = NULL;
         list->count = 0;
+        list->slots = 0;
         list->capacity = 0;
     }
 }
 
-bool task_list_add(TaskList *list, const Task *task) {
-    if (list->count >= list->capacity) {
-        int new_capacity = list->capacity * 2;
-        Task *new_tasks = realloc(list->tasks, new_capacity * sizeof(Task));
-        if (new_tasks == NULL) {
-            return false; // Reallocation failed
+// Grows a bitset from `old_capacity` to `new_capacity` bits. The new bits are
+// clear.
+static bool grow_bits(uint64_t **bits, int old_capacity, int new_capacity) {
+    uint64_t *new_bits =
+        ordo_realloc(*bits, BIT_WORDS(new_capacity) * sizeof(uint64_t));
+    if (new_bits == NULL) {
+        return false;
+    }
+    memset(new_bits + BIT_WORDS(old_capacity), 0,
+           (BIT_WORDS(new_capacity) - BIT_WORDS(old_capacity)) * sizeof(uint64_t));
+    *bits = new_bits;
+    return true;
+}
+
+// Grows the task array so that it has at least one more slot.
+static bool ensure_capacity(TaskList *list) {
+    if (list->slots < list->capacity) {
+        return true;
+    }
+    int new_capacity = list->capacity * 2;
+    Task *new_tasks = ordo_realloc(list->tasks, new_capacity * sizeof(Task));
+    if (new_tasks == NULL) {
+        return false; // Reallocation failed
+    }
+    list->tasks = new_tasks;
+    // On failure the larger arrays are kept for the next attempt.
+    if (!grow_bits(&list->live_bits, list->capacity, new_capacity) ||
+        !grow_bits(&list->done_bits, list->capacity, new_capacity)) {
+        return false;
+    }
+    list->capacity = new_capacity;
+    return true;
+}
+
+// --- Bitsets ---
+// Bit i of `live_bits` tells whether slot i holds a task, and bit i of
+// `done_bits` mirrors `tasks[i].concluida` for the slots that do. Bits of
+// tombstones and past the last slot are always clear, so whole words can be
+// counted without masking.
+
+static int popcount64(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static int ctz64(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int count = 0;
+    for (; !(word & 1); word >>= 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+static void set_bit(uint64_t *bits, int index, bool value) {
+    uint64_t bit = UINT64_C(1) << (index % 64);
+    if (value) {
+        bits[index / 64] |= bit;
+    } else {
+        bits[index / 64] &= ~bit;
+    }
+}
+
+static bool get_bit(const uint64_t *bits, int index) {
+    return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+// Moves the bits `[index, end)` up by one, into `[index + 1, end]`, leaving
+// bit `index` clear. Bit `end` must be clear; the bits past it stay as they
+// are.
+static void shift_bits_up(uint64_t *bits, int index, int end) {
+    int first = index / 64;
+    int last = end / 64;
+    // The bits of the last word up to and including `end`. The shift is done
+    // in unsigned arithmetic, so `end % 64 == 63` yields an all-ones mask.
+    uint64_t upto_end = (UINT64_C(2) << (end % 64)) - 1;
+    uint64_t past_end = bits[last] & ~upto_end;
+    for (int w = last; w > first; w--) {
+        bits[w] = (bits[w] << 1) | (bits[w - 1] >> 63);
+    }
+    uint64_t low = (UINT64_C(1) << (index % 64)) - 1;
+    bits[first] = (bits[first] & low) | ((bits[first] & ~low) << 1);
+    bits[last] = (bits[last] & upto_end) | past_end;
+}
+
+// The number of tasks in the slots before `index`.
+static int live_before(const TaskList *list, int index) {
+    if (list->slots == list->count) {
+        return index; // No tombstones
+    }
+    int live = 0;
+    for (int w = 0; w < index / 64; w++) {
+        live += popcount64(list->live_bits[w]);
+    }
+    if (index % 64 != 0) {
+        uint64_t low = (UINT64_C(1) << (index % 64)) - 1;
+        live += popcount64(list->live_bits[index / 64] & low);
+    }
+    return live;
+}
+
+// The index of the task with `live` tasks before it, or -1 if there are not
+// that many.
+static int nth_live(const TaskList *list, int live) {
+    if (live < 0 || live >= list->count) {
+        return -1;
+    }
+    if (list->slots == list->count) {
+        return live; // No tombstones
+    }
+    for (int w = 0;; w++) {
+        uint64_t word = list->live_bits[w];
+        int in_word = popcount64(word);
+        if (live < in_word) {
+            for (; live > 0; live--) {
+                word &= word - 1;
+            }
+            return w * 64 + ctz64(word);
+        }
+        live -= in_word;
+    }
+}
+
+// --- ID Table ---
+// Open addressing with linear probing. A removal moves the entries that follow
+// it back into the hole, so lookups never have to skip deleted slots.
+
+// The first slot probed for an ID (Fibonacci hashing).
+static int home_slot(const TaskList *list, int id) {
+    return (int)(((unsigned int)id * 2654435769u) &
+                 (unsigned int)(list->id_table_capacity - 1));
+}
+
+// Returns the slot holding `id`, or the empty slot where it would go.
+static TaskListSlot *probe(const TaskList *list, int id) {
+    int mask = list->id_table_capacity - 1;
+    int slot = home_slot(list, id);
+    while (list->id_table[slot].index >= 0 && list->id_table[slot].id != id) {
+        slot = (slot + 1) & mask;
+    }
+    return &list->id_table[slot];
+}
+
+// Records the index of a task.
+static void index_put(TaskList *list, int id, int index) {
+    TaskListSlot *slot = probe(list, id);
+    slot->id = id;
+    slot->index = index;
+}
+
+// Forgets the index of a task.
+static void index_delete(TaskList *list, int id) {
+    int mask = list->id_table_capacity - 1;
+    int hole = (int)(probe(list, id) - list->id_table);
+    if (list->id_table[hole].index < 0) {
+        return;
+    }
+    // Move back every following entry of the run that may not stay after the
+    // hole, i.e. whose home slot is not in (hole, slot].
+    for (int slot = (hole + 1) & mask; list->id_table[slot].index >= 0;
+         slot = (slot + 1) & mask) {
+        int home = home_slot(list, list->id_table[slot].id);
+        bool stays = hole <= slot ? (hole < home && home <= slot)
+                                  : (hole < home || home <= slot);
+        if (!stays) {
+            list->id_table[hole] = list->id_table[slot];
+            hole = slot;
         }
-        list->tasks = new_tasks;
-        list->capacity = new_capacity;
     }
-    
-    // Copy the task data to the list.
-    list->tasks[list->count].id = task->id;
-    list->tasks[list->count].concluida = task->concluida;
-    safe_snprintf(list->tasks[list->count].descricao, MAX_DESCRICAO, "%s", task->descricao);
+    list->id_table[hole].index = -1;
+}
+
+// Records the indexes of the tasks from `first` to the end of the list, e.g.
+// after they were shifted.
+static void index_range(TaskList *list, int first) {
+    for (int i = task_list_next(list, first); i >= 0; i = task_list_next(list, i + 1)) {
+        index_put(list, list->tasks[i].id, i);
+    }
+}
+
+// Empties the table and indexes every task again.
+static void index_rebuild(TaskList *list) {
+    for (int i = 0; i < list->id_table_capacity; i++) {
+        list->id_table[i].index = -1;
+    }
+    index_range(list, 0);
+}
+
+// Grows the table so that it can index at least one more task.
+static bool ensure_index_capacity(TaskList *list) {
+    if ((list->count + 1) * 2 <= list->id_table_capacity) {
+        return true;
+    }
+    int new_capacity = list->id_table_capacity ? list->id_table_capacity * 2
+                                               : ID_TABLE_MIN_CAPACITY;
+    while ((list->count + 1) * 2 > new_capacity) {
+        new_capacity *= 2;
+    }
+    TaskListSlot *new_table = ordo_malloc(new_capacity * sizeof(TaskListSlot));
+    if (new_table == NULL) {
+        return false;
+    }
+    free(list->id_table);
+    list->id_table = new_table;
+    list->id_table_capacity = new_capacity;
+    index_rebuild(list);
+    return true;
+}
 
+// --- Storage ---
+
+// Copies a description to the end of the arena, starting a new chunk if it
+// does not fit in the current one. Returns NULL if allocation fails.
+static const char *arena_store(TaskList *list, const char *text) {
+    if (text == NULL || text[0] == '\0') {
+        return "";
+    }
+    size_t length = strlen(text) + 1;
+    TaskListChunk *chunk = list->arena;
+    if (chunk == NULL || chunk->size - chunk->used < length) {
+        size_t size = chunk ? chunk->size * 2 : ARENA_MIN_CHUNK;
+        if (size > ARENA_MAX_CHUNK) {
+            size = ARENA_MAX_CHUNK;
+        }
+        if (size < length) {
+            size = length;
+        }
+        TaskListChunk *new_chunk = ordo_malloc(sizeof(TaskListChunk) + size);
+        if (new_chunk == NULL) {
+            return NULL;
+        }
+        new_chunk->next = chunk;
+        new_chunk->size = size;
+        new_chunk->used = 0;
+        list->arena = chunk = new_chunk;
+    }
+    char *copy = chunk->data + chunk->used;
+    memcpy(copy, text, length);
+    chunk->used += length;
+    return copy;
+}
+
+// Copies the task data into a slot of the list that already holds a task. The
+// description only takes new arena space if it changed.
+static bool copy_task(TaskList *list, Task *dest, const Task *src) {
+    const char *text = src->descricao ? src->descricao : "";
+    if (text != dest->descricao && strcmp(text, dest->descricao) != 0) {
+        text = arena_store(list, text);
+        if (text == NULL) {
+            return false;
+        }
+    } else {
+        text = dest->descricao;
+    }
+    int index = (int)(dest - list->tasks);
+    task_view_detach(list, index);
+    dest->id = src->id;
+    dest->descricao = text;
+    dest->concluida = src->concluida;
+    dest->is_deleted = src->is_deleted;
+    set_bit(list->done_bits, index, src->concluida);
+    task_view_attach(list, index);
+    return true;
+}
+
+// The first tombstone at or after `index`, or `list->slots` if there is none.
+static int next_hole(const TaskList *list, int index) {
+    if (list->slots == list->count) {
+        return list->slots; // No tombstones
+    }
+    for (int w = index / 64; w < BIT_WORDS(list->slots); w++) {
+        uint64_t holes = ~list->live_bits[w];
+        if (w == index / 64) {
+            holes &= ~((UINT64_C(1) << (index % 64)) - 1);
+        }
+        if (holes) {
+            int hole = w * 64 + ctz64(holes);
+            return hole < list->slots ? hole : list->slots;
+        }
+    }
+    return list->slots;
+}
+
+// Stores a task in the slot at the given index, where the tasks from `index`
+// on have IDs above its own. A tombstone on either side of that spot takes the
+// task as is; otherwise the tasks up to the next tombstone (or the end) move
+// up by one. The task's description must already be in the arena.
+static bool place_at(TaskList *list, int index, const Task *task) {
+    if (!ensure_capacity(list) || !ensure_index_capacity(list)) {
+        return false;
+    }
+    int end = index; // The tasks in [index, end) move up by one
+    if (index > 0 && !get_bit(list->live_bits, index - 1)) {
+        end = --index; // Reuse the tombstone before
+    } else if (index == list->slots || !get_bit(list->live_bits, index)) {
+        // Reuse the tombstone at the spot, or append
+    } else {
+        end = next_hole(list, index);
+        safe_memmove(&list->tasks[index + 1], &list->tasks[index], (end - index) * sizeof(Task));
+        shift_bits_up(list->live_bits, index, end);
+        shift_bits_up(list->done_bits, index, end);
+    }
+    if (end == list->slots) {
+        list->slots++;
+    }
+    list->tasks[index] = *task;
+    set_bit(list->live_bits, index, true);
+    set_bit(list->done_bits, index, task->concluida);
     list->count++;
+    for (int i = index; i <= end; i++) {
+        if (get_bit(list->live_bits, i)) {
+            index_put(list, list->tasks[i].id, i);
+        }
+    }
+    task_view_inserted(list, index, end);
     return true;
 }
 
+// Inserts a copy of a task at the given index, shifting the following tasks.
+static bool insert_at(TaskList *list, int index, const Task *task) {
+    Task stored = *task;
+    stored.descricao = arena_store(list, task->descricao);
+    return stored.descricao != NULL && place_at(list, index, &stored);
+}
+
+// Returns the index of the first slot whose ID is not less than `task_id`.
+// Tombstones keep the ID of their last task, so the slots stay in ID order.
+static int lower_bound(const TaskList *list, int task_id) {
+    int low = 0, high = list->slots;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (list->tasks[mid].id < task_id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool task_list_add(TaskList *list, const Task *task) {
+    if (!insert_at(list, list->slots, task)) {
+        return false;
+    }
+    if (!list->windowed) {
+        list->total_count = list->count;
+    }
+    return true;
+}
+
+// Moves the tasks down over the tombstones. Every task may change its index.
+static void compact(TaskList *list) {
+    // Where each slot's task ends up, for the views.
+    int *moved_to = ordo_malloc(list->slots * sizeof(int));
+    if (moved_to == NULL) {
+        return; // The tombstones stay until the next attempt
+    }
+    int next = 0;
+    for (int i = task_list_next(list, 0); i >= 0; i = task_list_next(list, i + 1)) {
+        moved_to[i] = next;
+        list->tasks[next++] = list->tasks[i];
+    }
+    memset(list->live_bits, 0, BIT_WORDS(list->slots) * sizeof(uint64_t));
+    memset(list->done_bits, 0, BIT_WORDS(list->slots) * sizeof(uint64_t));
+    list->slots = list->count;
+    for (int i = 0; i < list->count; i++) {
+        set_bit(list->live_bits, i, true);
+        set_bit(list->done_bits, i, list->tasks[i].concluida);
+    }
+    index_range(list, 0);
+    task_view_remap(list, moved_to);
+    free(moved_to);
+}
+
 void task_list_remove(TaskList *list, int index) {
-    if (index < 0 || index >= list->count) {
+    if (index < 0 || index >= list->slots || !get_bit(list->live_bits, index)) {
         return; // Invalid index
     }
 
-    // Move subsequent tasks to fill the space.
-    if (index < list->count - 1) {
-        safe_memmove(&list->tasks[index], &list->tasks[index + 1], (list->count - index - 1) * sizeof(Task));
+    // The slot becomes a tombstone; no other task moves.
+    task_view_removing(list, index);
+    index_delete(list, list->tasks[index].id);
+    set_bit(list->live_bits, index, false);
+    set_bit(list->done_bits, index, false);
+    list->count--;
+
+    // Tombstones at the end are dropped right away.
+    while (list->slots > 0 && !get_bit(list->live_bits, list->slots - 1)) {
+        list->slots--;
     }
+    if ((list->slots - list->count) * TOMBSTONE_SHARE > list->slots) {
+        compact(list);
+    }
+}
 
-    list->count--;
+int task_list_next(const TaskList *list, int index) {
+    if (index < 0) {
+        index = 0;
+    }
+    for (int w = index / 64; w < BIT_WORDS(list->slots); w++) {
+        uint64_t live = list->live_bits[w];
+        if (w == index / 64) {
+            live &= ~((UINT64_C(1) << (index % 64)) - 1);
+        }
+        if (live) {
+            return w * 64 + ctz64(live); // Bits past the last slot are clear
+        }
+    }
+    return -1;
 }
 
 void task_list_clear(TaskList *list) {
-    // Just reset the count. The allocated memory can be reused.
+    // Just reset the count. The task array can be reused, and so can the
+    // newest (largest) arena chunk; the older ones are freed.
+    if (list->arena) {
+        free_chunks(list->arena->next);
+        list->arena->next = NULL;
+        list->arena->used = 0;
+    }
+    memset(list->live_bits, 0, BIT_WORDS(list->slots) * sizeof(uint64_t));
+    memset(list->done_bits, 0, BIT_WORDS(list->slots) * sizeof(uint64_t));
     list->count = 0;
+    list->slots = 0;
+    list->generation = atomic_fetch_add(&next_generation, 1);
+    list->window_start = 0;
+    list->total_count = 0;
+    index_rebuild(list);
+    task_view_reset(list); // Until the active view is built again
+}
+
+// The index of the active view, or NULL if the list is shown as is.
+static const TaskViewIndex *active_view(const TaskList *list) {
+    const TaskViewIndex *view = &list->views[list->view];
+    return list->view != TASK_VIEW_ALL && view->built ? view : NULL;
+}
+
+int task_list_total(const TaskList *list) {
+    const TaskViewIndex *view = active_view(list);
+    return view ? view->count : list->total_count;
+}
+
+Task *task_list_at(const TaskList *list, int position) {
+    int index = task_list_seek(list, position).index;
+    return index >= 0 ? &list->tasks[index] : NULL;
+}
+
+TaskListCursor task_list_seek(const TaskList *list, int position) {
+    TaskListCursor cursor = {position, -1};
+    const TaskViewIndex *view = active_view(list);
+    if (view) {
+        if (position >= 0 && position < view->count) {
+            cursor.index = view->indexes[position];
+        }
+    } else {
+        cursor.index = nth_live(list, position - list->window_start);
+    }
+    return cursor;
+}
+
+void task_list_advance(const TaskList *list, TaskListCursor *cursor) {
+    cursor->position++;
+    if (cursor->index < 0) {
+        return;
+    }
+    const TaskViewIndex *view = active_view(list);
+    if (view) {
+        cursor->index = cursor->position < view->count
+                            ? view->indexes[cursor->position]
+                            : -1;
+    } else {
+        cursor->index = task_list_next(list, cursor->index + 1);
+    }
+}
+
+int task_list_position(const TaskList *list, int index) {
+    if (active_view(list)) {
+        return task_view_position(list, list->view, index);
+    }
+    return list->window_start + live_before(list, index);
+}
+
+bool task_list_set_view(TaskList *list, TaskViewKind kind) {
+    if (list->windowed && kind != TASK_VIEW_ALL) {
+        return false;
+    }
+    if (!list->views[kind].built && !task_view_build(list, kind)) {
+        return false;
+    }
+    list->view = kind;
+    return true;
+}
+
+bool task_list_covers(const TaskList *list, int first, int length) {
+    int last = first + length;
+    if (last > list->total_count) {
+        last = list->total_count;
+    }
+    if (first < 0) {
+        first = 0;
+    }
+    return first >= list->window_start &&
+           last <= list->window_start + list->count;
+}
+
+int task_list_find(const TaskList *list, int task_id) {
+    if (list->id_table_capacity == 0) {
+        return -1; // Nothing was ever added
+    }
+    return probe(list, task_id)->index;
+}
+
+bool task_list_rename(TaskList *list, int old_id, int new_id) {
+    int index = task_list_find(list, old_id);
+    if (index < 0) {
+        return false;
+    }
+    task_view_detach(list, index);
+    index_delete(list, old_id);
+    list->tasks[index].id = new_id;
+    index_put(list, new_id, index);
+    task_view_attach(list, index);
+    return true;
+}
+
+void task_list_reverse(TaskList *list) {
+    for (int i = 0, j = list->slots - 1; i < j; ++i, --j) {
+        Task tmp = list->tasks[i];
+        list->tasks[i] = list->tasks[j];
+        list->tasks[j] = tmp;
+        bool live = get_bit(list->live_bits, i);
+        set_bit(list->live_bits, i, get_bit(list->live_bits, j));
+        set_bit(list->live_bits, j, live);
+        bool done = get_bit(list->done_bits, i);
+        set_bit(list->done_bits, i, get_bit(list->done_bits, j));
+        set_bit(list->done_bits, j, done);
+    }
+    index_range(list, 0);
+    task_view_reset(list);
+}
+
+int task_list_count_status(const TaskList *list, int concluida) {
+    int done = 0;
+    for (int w = 0; w < BIT_WORDS(list->slots); w++) {
+        done += popcount64(list->done_bits[w]);
+    }
+    return concluida ? done : list->count - done;
+}
+
+int task_list_filter_status(const TaskList *list, int concluida, int *indexes) {
+    int found = 0;
+    for (int w = 0; w < BIT_WORDS(list->slots); w++) {
+        // 64 tasks at a time: only the set bits are visited. Tombstones and
+        // the bits past the last slot are clear in both bitsets.
+        uint64_t word = concluida ? list->done_bits[w]
+                                  : list->live_bits[w] & ~list->done_bits[w];
+        for (; word; word &= word - 1) {
+            indexes[found++] = w * 64 + ctz64(word);
+        }
+    }
+    return found;
+}
+
+bool task_list_apply(TaskList *list, const Task *row, int was_deleted) {
+    bool was_in_view = (was_deleted == list->deleted_scope);
+    bool is_in_view = (row->is_deleted == list->deleted_scope);
+    int index = task_list_find(list, row->id);
+
+    if (index >= 0) {
+        // A cached row is known to be part of the view.
+        if (is_in_view) {
+            return copy_task(list, &list->tasks[index], row);
+        } else {
+            task_list_remove(list, index);
+            list->total_count--;
+        }
+        return true;
+    }
+
+    index = lower_bound(list, row->id);
+
+    if (was_in_view == is_in_view) {
+        return true; // Nothing cached to patch
+    }
+
+    if (was_in_view) {
+        task_list_forget(list, row->id, was_deleted);
+        return true;
+    }
+
+    // The row enters the view. Only store it if it falls inside the window.
+    if (index == 0 && list->window_start > 0) {
+        list->window_start++; // It precedes the window
+    } else if (index == list->slots &&
+               list->window_start + list->count < list->total_count) {
+        // It follows the window
+    } else if (!insert_at(list, index, row)) {
+        return false;
+    }
+    list->total_count++;
+    return true;
+}
+
+void task_list_forget(TaskList *list, int task_id, int was_deleted) {
+    if (was_deleted != list->deleted_scope) {
+        return; // The row was never part of this view
+    }
+
+    int index = task_list_find(list, task_id);
+    if (index >= 0) {
+        task_list_remove(list, index);
+    } else if (list->slots > 0 && task_id < list->tasks[0].id) {
+        list->window_start--; // It preceded the window
+    }
+    list->total_count--;
 }
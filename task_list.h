@@ -4,24 +4,71 @@
  *
  * This module provides an abstraction of a task list that can grow
  * dynamically, avoiding manual memory management in the rest of the application.
+ *
+ * The list owns the descriptions of its tasks. They are copied into a string
+ * arena: chunks that are filled front to back and never move, so a task's
+ * `descricao` stays valid while the task is in the list, and until the next
+ * `task_list_clear` after it is removed or replaced. The arena is freed as a
+ * whole when the list is cleared rather than string by string.
+ *
+ * Removing a task leaves a tombstone in its slot instead of moving every task
+ * that follows it; `count` only counts the live tasks. The tombstones are
+ * skipped by the accessors below, reused by later insertions next to them and
+ * compacted away once they take up a quarter of the slots. A list that is only
+ * ever added to has no tombstones, so its `tasks` can be read as a plain array
+ * of `count` tasks.
  */
 
 #ifndef TASK_LIST_H
 #define TASK_LIST_H
 
 #include "task.h"
+#include "task_view.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/** A block of the string arena; see task_list.c. */
+typedef struct TaskListChunk TaskListChunk;
+
+/** An entry of the ID table; see task_list.c. */
+typedef struct TaskListSlot TaskListSlot;
 
 /**
  * @struct TaskList
  * @brief Structure to encapsulate a dynamic list of tasks.
  */
-typedef struct {
+typedef struct TaskList {
     Task *tasks;      /**< Pointer to the dynamically allocated array of tasks. */
     int count;          /**< The current number of tasks in the list. */
+    int slots;          /**< The slots of `tasks` in use: the tasks and the tombstones among them. */
     int capacity;       /**< The current capacity of the task array. */
+    int deleted_scope;  /**< The `is_deleted` value shared by every task in the list. */
+    bool windowed;      /**< Whether only a window of the view is kept in memory. */
+    int window_start;   /**< Position, within the whole view, of the first task in the list. */
+    int total_count;    /**< The number of tasks in the whole view. */
+    TaskListChunk *arena; /**< The arena holding the descriptions, newest chunk first. */
+    uint64_t *live_bits;  /**< Bitset of the slots holding a task rather than a tombstone. */
+    uint64_t *done_bits;  /**< Bitset of the tasks' `concluida` flags, one bit per index. */
+    TaskListSlot *id_table; /**< Open-addressing table mapping each task ID to its index. */
+    int id_table_capacity;  /**< The number of slots in `id_table`, a power of two. */
+    TaskViewKind view;      /**< The view `task_list_at` and `task_list_total` go through. */
+    unsigned long generation; /**< Changed by `task_list_clear` to a value no list had before: descriptions handed out before are stale. */
+    TaskViewIndex views[TASK_VIEW_COUNT]; /**< The index of each view; see task_view.h. */
 } TaskList;
 
+/**
+ * @struct TaskListCursor
+ * @brief A position of the view and the index of the task shown there, for
+ * walking consecutive positions without looking each one up.
+ */
+typedef struct {
+    int position; /**< The position within the whole view. */
+    int index;    /**< The index of the task at `position`, or -1 if it is not in memory. */
+} TaskListCursor;
+
+/** `was_deleted` value for a row that did not exist before the change. */
+#define TASK_LIST_NEW_ROW -1
+
 // --- Lifecycle Functions ---
 
 /**
@@ -45,25 +92,181 @@ void task_list_free(TaskList *list);
  *
  * The function manages memory reallocation if the current capacity is exceeded.
  * @param[in,out] list Pointer to the `TaskList`.
- * @param[in] task Pointer to the task to be added. A copy will be made.
+ * @param[in] task Pointer to the task to be added. A copy will be made, also of
+ * its description.
  * @return `true` if the task was added successfully, `false` if memory reallocation fails.
  */
 bool task_list_add(TaskList *list, const Task *task);
 
 /**
  * @brief Removes a task from the list based on its index.
+ *
+ * Leaves a tombstone in the task's slot, so the other tasks keep their
+ * indexes unless the removal triggers a compaction.
  * @param[in,out] list Pointer to the `TaskList`.
  * @param[in] index The index of the task to be removed.
  */
 void task_list_remove(TaskList *list, int index);
 
+/**
+ * @brief Finds the first task at or after an index, skipping tombstones.
+ *
+ * `for (int i = task_list_next(list, 0); i >= 0; i = task_list_next(list, i + 1))`
+ * visits every task in ID order.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] index The index to start from.
+ * @return The index of the task, or -1 if no task follows.
+ */
+int task_list_next(const TaskList *list, int index);
+
 /**
  * @brief Clears the task list.
  *
- * Resets the task count to zero, but does not free the allocated memory,
- * allowing for reuse.
+ * Resets the task count and the window to zero and empties the string arena,
+ * invalidating every description the list handed out. The task array and the
+ * newest arena chunk are kept for reuse.
  * @param[in,out] list Pointer to the `TaskList` to be cleared.
  */
-void task_list_clear(TaskList *list); 
+void task_list_clear(TaskList *list);
+
+// --- Window Functions ---
+// Positions are indexes into the whole view: every task of the list's scope,
+// ordered by ID, or the tasks of the active filtered or sorted view. Outside
+// windowed mode the window always covers the view.
+
+/**
+ * @brief Returns the number of tasks in the whole view.
+ * @param[in] list Pointer to the `TaskList`.
+ */
+int task_list_total(const TaskList *list);
+
+/**
+ * @brief Returns the task at a position of the view, if it is in memory.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] position The position of the task within the whole view.
+ * @return A pointer to the task, or `NULL` if it is outside the window.
+ */
+Task *task_list_at(const TaskList *list, int position);
+
+/**
+ * @brief Places a cursor at a position of the view.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] position The position within the whole view.
+ * @return The cursor; its `index` is -1 if the position is not in memory.
+ */
+TaskListCursor task_list_seek(const TaskList *list, int position);
+
+/**
+ * @brief Moves a cursor to the next position of the view.
+ * @param[in] list Pointer to the `TaskList`, unchanged since the cursor was
+ * placed.
+ * @param[in,out] cursor The cursor; its `index` becomes -1 past the tasks in
+ * memory.
+ */
+void task_list_advance(const TaskList *list, TaskListCursor *cursor);
+
+/**
+ * @brief Returns the position of a task within the view.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] index The index of the task in the list.
+ * @return The position, or -1 if the active view leaves the task out.
+ */
+int task_list_position(const TaskList *list, int index);
+
+/**
+ * @brief Selects the view shown through `task_list_at`.
+ *
+ * Builds the view's index unless the list kept it up to date since it was
+ * last built. Also called after a bulk load to build the active view again.
+ * Windowed lists only support `TASK_VIEW_ALL`.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] kind The view.
+ * @return `false` if the view is not available, in which case the active view
+ * is left unchanged.
+ */
+bool task_list_set_view(TaskList *list, TaskViewKind kind);
+
+/**
+ * @brief Checks whether the positions `[first, first + length)` are in memory.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] first The first position of the range.
+ * @param[in] length The number of positions in the range.
+ */
+bool task_list_covers(const TaskList *list, int first, int length);
+
+// --- Status Functions ---
+// These work on the packed status bitset rather than on the tasks, and only
+// see the tasks in memory: in windowed mode, those of the window.
+
+/**
+ * @brief Counts the tasks with a given status.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] concluida 1 to count the completed tasks, 0 for the pending ones.
+ * @return The number of tasks.
+ */
+int task_list_count_status(const TaskList *list, int concluida);
+
+/**
+ * @brief Lists the indexes of the tasks with a given status, in list order.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] concluida 1 for the completed tasks, 0 for the pending ones.
+ * @param[out] indexes Receives the indexes; must have room for `list->count`
+ * entries.
+ * @return The number of indexes written.
+ */
+int task_list_filter_status(const TaskList *list, int concluida, int *indexes);
+
+// --- Write-Through Functions ---
+
+/**
+ * @brief Finds the index of a task by its ID.
+ *
+ * A lookup in the ID table, which every change to the list keeps up to date.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] task_id The ID of the task to look for.
+ * @return The index of the task, or -1 if it is not in the list.
+ */
+int task_list_find(const TaskList *list, int task_id);
+
+/**
+ * @brief Changes the ID of a task in place.
+ *
+ * The caller is responsible for keeping the list ordered by ID.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] old_id The current ID of the task.
+ * @param[in] new_id The new ID.
+ * @return `false` if the list does not hold the task.
+ */
+bool task_list_rename(TaskList *list, int old_id, int new_id);
+
+/**
+ * @brief Reverses the order of the tasks, e.g. after adding rows read in
+ * descending ID order.
+ * @param[in,out] list Pointer to the `TaskList`.
+ */
+void task_list_reverse(TaskList *list);
+
+/**
+ * @brief Reflects a changed database row in the list.
+ *
+ * The row is kept (in ID order) if its `is_deleted` value matches the scope of
+ * the list and removed otherwise. `was_deleted` tells whether the row belonged
+ * to the view before the change, so the view size stays exact even when the
+ * row lies outside the window.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] row The current state of the row.
+ * @param[in] was_deleted The `is_deleted` value before the change, or
+ * `TASK_LIST_NEW_ROW`.
+ * @return `true` on success, `false` if memory reallocation fails.
+ */
+bool task_list_apply(TaskList *list, const Task *row, int was_deleted);
+
+/**
+ * @brief Reflects a permanently deleted database row in the list.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] task_id The ID of the deleted task.
+ * @param[in] was_deleted The `is_deleted` value of the row before deletion.
+ */
+void task_list_forget(TaskList *list, int task_id, int was_deleted);
 
 #endif // TASK_LIST_H
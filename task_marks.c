@@ -0,0 +1,77 @@
+#include "task_marks.h"
+#include "perf_stats.h"
+#include "utils.h"
+#include <stdlib.h>
+
+// Index of the first ID not lower than `task_id`.
+static int lower_bound(const TaskMarks *marks, int task_id) {
+  int low = 0, high = marks->count;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (marks->ids[mid] < task_id)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+void task_marks_init(TaskMarks *marks) { *marks = (TaskMarks){0}; }
+
+void task_marks_free(TaskMarks *marks) {
+  free(marks->ids);
+  free(marks->states);
+  *marks = (TaskMarks){0};
+}
+
+void task_marks_clear(TaskMarks *marks) { marks->count = 0; }
+
+bool task_marks_toggle(TaskMarks *marks, const Task *task) {
+  int index = lower_bound(marks, task->id);
+  size_t tail = (size_t)(marks->count - index);
+  if (index < marks->count && marks->ids[index] == task->id) {
+    safe_memmove(&marks->ids[index], &marks->ids[index + 1],
+                 (tail - 1) * sizeof(int));
+    safe_memmove(&marks->states[index], &marks->states[index + 1],
+                 (tail - 1) * sizeof(int));
+    marks->count--;
+    return false;
+  }
+
+  if (marks->count == marks->capacity) {
+    int new_capacity = marks->capacity ? marks->capacity * 2 : 16;
+    int *new_ids = ordo_realloc(marks->ids, (size_t)new_capacity * sizeof(int));
+    if (!new_ids)
+      return false;
+    marks->ids = new_ids;
+    int *new_states =
+        ordo_realloc(marks->states, (size_t)new_capacity * sizeof(int));
+    if (!new_states)
+      return false;
+    marks->states = new_states;
+    marks->capacity = new_capacity;
+  }
+  safe_memmove(&marks->ids[index + 1], &marks->ids[index],
+               tail * sizeof(int));
+  safe_memmove(&marks->states[index + 1], &marks->states[index],
+               tail * sizeof(int));
+  marks->ids[index] = task->id;
+  marks->states[index] = task->concluida;
+  marks->count++;
+  return true;
+}
+
+bool task_marks_contains(const TaskMarks *marks, int task_id) {
+  int index = lower_bound(marks, task_id);
+  return index < marks->count && marks->ids[index] == task_id;
+}
+
+void task_marks_rename(TaskMarks *marks, int old_id, int new_id) {
+  int index = lower_bound(marks, old_id);
+  if (index == marks->count || marks->ids[index] != old_id)
+    return;
+  Task task = {.id = old_id, .concluida = marks->states[index]};
+  task_marks_toggle(marks, &task);
+  task.id = new_id;
+  task_marks_toggle(marks, &task);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file task_marks.h
+ * @brief Defines the set of tasks marked for a multi-task action.
+ *
+ * Marks are kept by task ID, so they survive scrolling, window reloads and
+ * changes to the position of a task in the list. The status of each task is
+ * recorded when it is marked, because in windowed mode a marked task may no
+ * longer be in memory when the action is applied.
+ */
+
+#ifndef TASK_MARKS_H
+#define TASK_MARKS_H
+
+#include "task.h"
+#include <stdbool.h>
+
+/**
+ * @struct TaskMarks
+ * @brief A sorted set of task IDs.
+ */
+typedef struct {
+  int *ids;     /**< Sorted array of the marked task IDs. */
+  int *states;  /**< The status of each marked task when it was marked. */
+  int count;    /**< The number of marked tasks. */
+  int capacity; /**< The capacity of the ID array. */
+} TaskMarks;
+
+/**
+ * @brief Initializes an empty set of marks.
+ * @param[out] marks Pointer to the `TaskMarks` to be initialized.
+ */
+void task_marks_init(TaskMarks *marks);
+
+/**
+ * @brief Frees the memory allocated by the set of marks.
+ * @param[in] marks Pointer to the `TaskMarks` to be freed.
+ */
+void task_marks_free(TaskMarks *marks);
+
+/**
+ * @brief Removes every mark.
+ * @param[in,out] marks Pointer to the `TaskMarks`.
+ */
+void task_marks_clear(TaskMarks *marks);
+
+/**
+ * @brief Marks a task, or unmarks it if it was already marked.
+ * @param[in,out] marks Pointer to the `TaskMarks`.
+ * @param[in] task The task.
+ * @return `true` if the task is now marked.
+ */
+bool task_marks_toggle(TaskMarks *marks, const Task *task);
+
+/**
+ * @brief Checks whether a task is marked.
+ * @param[in] marks Pointer to the `TaskMarks`.
+ * @param[in] task_id The ID of the task.
+ * @return `true` if the task is marked.
+ */
+bool task_marks_contains(const TaskMarks *marks, int task_id);
+
+/**
+ * @brief Changes the ID of a marked task, keeping its mark.
+ * @param[in,out] marks Pointer to the `TaskMarks`.
+ * @param[in] old_id The current ID of the task.
+ * @param[in] new_id The new ID of the task.
+ */
+void task_marks_rename(TaskMarks *marks, int old_id, int new_id);
+
+#endif // TASK_MARKS_H
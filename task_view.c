@@ -0,0 +1,230 @@
+#include "task_view.h"
+#include "perf_stats.h"
+#include "task_list.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MIN_VIEW_CAPACITY 16
+
+// Whether a view shows a task at all.
+static bool shows(TaskViewKind kind, const Task *task) {
+  if (kind == TASK_VIEW_PENDING)
+    return !task->concluida;
+  if (kind == TASK_VIEW_DONE)
+    return task->concluida;
+  return true;
+}
+
+// Orders two tasks of the list, given by index, the way a view shows them.
+// The ID breaks every tie, so no two tasks compare equal.
+static int compare(const TaskList *list, TaskViewKind kind, int a, int b) {
+  const Task *x = &list->tasks[a];
+  const Task *y = &list->tasks[b];
+  if (kind == TASK_VIEW_BY_DESCRIPTION) {
+    int order = strcasecmp(x->descricao, y->descricao);
+    if (order != 0)
+      return order;
+  } else if (kind == TASK_VIEW_BY_STATUS && x->concluida != y->concluida) {
+    return x->concluida - y->concluida;
+  }
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+// Position of the first entry of the view not ordered before the task at
+// `index`.
+static int lower_bound(const TaskList *list, TaskViewKind kind, int index) {
+  const TaskViewIndex *view = &list->views[kind];
+  int low = 0, high = view->count;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (compare(list, kind, view->indexes[mid], index) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+static bool reserve(TaskViewIndex *view, int capacity) {
+  if (capacity <= view->capacity)
+    return true;
+  int new_capacity = view->capacity ? view->capacity : MIN_VIEW_CAPACITY;
+  while (new_capacity < capacity)
+    new_capacity *= 2;
+  int *indexes =
+      ordo_realloc(view->indexes, sizeof(int) * (size_t)new_capacity);
+  if (!indexes)
+    return false;
+  view->indexes = indexes;
+  view->capacity = new_capacity;
+  return true;
+}
+
+// Adds the task at `index` to a built view, if the view shows it.
+static void add_entry(TaskList *list, TaskViewKind kind, int index) {
+  TaskViewIndex *view = &list->views[kind];
+  if (!shows(kind, &list->tasks[index]))
+    return;
+  if (!reserve(view, view->count + 1)) {
+    view->built = false; // Out of date; built again when next selected
+    return;
+  }
+  int position = lower_bound(list, kind, index);
+  safe_memmove(&view->indexes[position + 1], &view->indexes[position],
+               sizeof(int) * (size_t)(view->count - position));
+  view->indexes[position] = index;
+  view->count++;
+}
+
+// Takes the task at `index` out of a built view, if the view shows it.
+static void remove_entry(TaskList *list, TaskViewKind kind, int index) {
+  TaskViewIndex *view = &list->views[kind];
+  if (!shows(kind, &list->tasks[index]))
+    return;
+  int position = lower_bound(list, kind, index);
+  if (position < view->count && view->indexes[position] == index) {
+    safe_memmove(&view->indexes[position], &view->indexes[position + 1],
+                 sizeof(int) * (size_t)(view->count - position - 1));
+    view->count--;
+  }
+}
+
+typedef struct {
+  const char *text;
+  int id;
+  int index;
+} DescriptionKey;
+
+static int compare_descriptions(const void *a, const void *b) {
+  const DescriptionKey *x = a;
+  const DescriptionKey *y = b;
+  int order = strcasecmp(x->text, y->text);
+  if (order != 0)
+    return order;
+  return (x->id > y->id) - (x->id < y->id);
+}
+
+// Sorts every task of the list by description into the view.
+static bool sort_by_description(const TaskList *list, TaskViewIndex *view) {
+  size_t count = list->count > 0 ? (size_t)list->count : 1;
+  DescriptionKey *keys = ordo_malloc(sizeof(DescriptionKey) * count);
+  if (!keys)
+    return false;
+  int k = 0;
+  for (int i = task_list_next(list, 0); i >= 0; i = task_list_next(list, i + 1))
+    keys[k++] = (DescriptionKey){list->tasks[i].descricao, list->tasks[i].id, i};
+  qsort(keys, (size_t)list->count, sizeof(DescriptionKey),
+        compare_descriptions);
+  for (int i = 0; i < list->count; i++)
+    view->indexes[i] = keys[i].index;
+  view->count = list->count;
+  free(keys);
+  return true;
+}
+
+bool task_view_build(TaskList *list, TaskViewKind kind) {
+  if (kind == TASK_VIEW_ALL)
+    return true;
+  TaskViewIndex *view = &list->views[kind];
+  view->built = false;
+  if (!reserve(view, list->count))
+    return false;
+
+  // The list is kept by ID, so the status bitset yields the filtered views
+  // already in order.
+  switch (kind) {
+  case TASK_VIEW_PENDING:
+    view->count = task_list_filter_status(list, 0, view->indexes);
+    break;
+  case TASK_VIEW_DONE:
+    view->count = task_list_filter_status(list, 1, view->indexes);
+    break;
+  case TASK_VIEW_BY_STATUS:
+    view->count = task_list_filter_status(list, 0, view->indexes);
+    view->count +=
+        task_list_filter_status(list, 1, view->indexes + view->count);
+    break;
+  case TASK_VIEW_BY_DESCRIPTION:
+    if (!sort_by_description(list, view))
+      return false;
+    break;
+  case TASK_VIEW_ALL:
+  case TASK_VIEW_COUNT:
+    break;
+  }
+  view->built = true;
+  return true;
+}
+
+void task_view_reset(TaskList *list) {
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    list->views[kind].count = 0;
+    list->views[kind].built = false;
+  }
+}
+
+void task_view_free(TaskList *list) {
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    free(list->views[kind].indexes);
+    list->views[kind] = (TaskViewIndex){0};
+  }
+}
+
+void task_view_inserted(TaskList *list, int index, int end) {
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    TaskViewIndex *view = &list->views[kind];
+    if (!view->built)
+      continue;
+    // Nothing moved when the task took a free slot.
+    if (index < end) {
+      for (int i = 0; i < view->count; i++) {
+        if (view->indexes[i] >= index && view->indexes[i] < end)
+          view->indexes[i]++;
+      }
+    }
+    add_entry(list, kind, index);
+  }
+}
+
+void task_view_removing(TaskList *list, int index) {
+  // The slot becomes a tombstone, so no other entry changes.
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    if (list->views[kind].built)
+      remove_entry(list, kind, index);
+  }
+}
+
+void task_view_remap(TaskList *list, const int *moved_to) {
+  // Moving tasks keeps their order, so every view stays sorted.
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    TaskViewIndex *view = &list->views[kind];
+    if (!view->built)
+      continue;
+    for (int i = 0; i < view->count; i++)
+      view->indexes[i] = moved_to[view->indexes[i]];
+  }
+}
+
+void task_view_detach(TaskList *list, int index) {
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    if (list->views[kind].built)
+      remove_entry(list, kind, index);
+  }
+}
+
+void task_view_attach(TaskList *list, int index) {
+  for (int kind = 0; kind < TASK_VIEW_COUNT; kind++) {
+    if (list->views[kind].built)
+      add_entry(list, kind, index);
+  }
+}
+
+int task_view_position(const TaskList *list, TaskViewKind kind, int index) {
+  const TaskViewIndex *view = &list->views[kind];
+  int position = lower_bound(list, kind, index);
+  if (position < view->count && view->indexes[position] == index)
+    return position;
+  return -1;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file task_view.h
+ * @brief Filtered and sorted views of a task list, kept as index vectors.
+ *
+ * A view is the list of indexes, into a `TaskList`, of the tasks it shows, in
+ * the order it shows them; no task is ever copied. Once built, a view is
+ * updated by the task list on every change (an insertion, removal or patch
+ * moves a single entry), so switching between views that were built before is
+ * instant and needs no query. `task_list_clear` drops every view; the active
+ * one is built again by `task_list_set_view` once the list is loaded.
+ *
+ * The functions in this header are the task list's side of that contract.
+ * The rest of the application selects and reads views through `task_list.h`.
+ */
+
+#ifndef TASK_VIEW_H
+#define TASK_VIEW_H
+
+#include <stdbool.h>
+
+struct TaskList;
+
+/**
+ * @enum TaskViewKind
+ * @brief The ways a task list can be shown.
+ */
+typedef enum {
+  TASK_VIEW_ALL,            /**< Every task, by ID: the list itself. */
+  TASK_VIEW_PENDING,        /**< The pending tasks, by ID. */
+  TASK_VIEW_DONE,           /**< The completed tasks, by ID. */
+  TASK_VIEW_BY_DESCRIPTION, /**< Every task, by description, then by ID. */
+  TASK_VIEW_BY_STATUS,      /**< Every task, the pending ones first, then by ID. */
+  TASK_VIEW_COUNT
+} TaskViewKind;
+
+/**
+ * @struct TaskViewIndex
+ * @brief The indexes of the tasks shown by one view.
+ */
+typedef struct {
+  int *indexes; /**< Indexes into the list's tasks, in view order. */
+  int count;    /**< The number of tasks in the view. */
+  int capacity; /**< The capacity of `indexes`. */
+  bool built;   /**< Whether the view reflects the list; if not, it is ignored. */
+} TaskViewIndex;
+
+/**
+ * @brief Builds the index of a view from the tasks currently in the list.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] kind The view to build.
+ * @return `false` if memory allocation fails.
+ */
+bool task_view_build(struct TaskList *list, TaskViewKind kind);
+
+/**
+ * @brief Drops the index of every view, keeping its memory for reuse.
+ * @param[in,out] list Pointer to the `TaskList`.
+ */
+void task_view_reset(struct TaskList *list);
+
+/**
+ * @brief Frees the indexes of every view.
+ * @param[in,out] list Pointer to the `TaskList`.
+ */
+void task_view_free(struct TaskList *list);
+
+/**
+ * @brief Updates the views after a task was inserted at `index`.
+ * @param[in,out] list Pointer to the `TaskList`, already holding the task.
+ * @param[in] index The index of the new task.
+ * @param[in] end The tasks that were at `[index, end)` moved up by one slot to
+ * make room; `index` if none did.
+ */
+void task_view_inserted(struct TaskList *list, int index, int end);
+
+/**
+ * @brief Updates the views before the task at `index` is removed.
+ * @param[in,out] list Pointer to the `TaskList`, still holding the task.
+ * @param[in] index The index of the task.
+ */
+void task_view_removing(struct TaskList *list, int index);
+
+/**
+ * @brief Updates the views after the list moved its tasks to new slots.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] moved_to The new index of each task, by old index.
+ */
+void task_view_remap(struct TaskList *list, const int *moved_to);
+
+/**
+ * @brief Takes the task at `index` out of the views before it is changed in
+ * place. Must be followed by `task_view_attach` once the change is done.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] index The index of the task.
+ */
+void task_view_detach(struct TaskList *list, int index);
+
+/**
+ * @brief Puts the task at `index` back into the views after a change.
+ * @param[in,out] list Pointer to the `TaskList`.
+ * @param[in] index The index of the task.
+ */
+void task_view_attach(struct TaskList *list, int index);
+
+/**
+ * @brief Finds where a view shows a task.
+ * @param[in] list Pointer to the `TaskList`.
+ * @param[in] kind A built view other than `TASK_VIEW_ALL`.
+ * @param[in] index The index of the task in the list.
+ * @return The position of the task in the view, or -1 if the view leaves it
+ * out.
+ */
+int task_view_position(const struct TaskList *list, TaskViewKind kind,
+                       int index);
+
+#endif // TASK_VIEW_H
@@ -0,0 +1,274 @@
+#include "text_editor.h"
+#include "perf_stats.h"
+#include "utf8_width.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MIN_EDITOR_CAPACITY 64
+
+// Columns a character takes; the few that report none are drawn in one.
+static int char_width(wchar_t ch) {
+  int width = utf8_codepoint_width((uint32_t)ch);
+  return width < 0 ? 1 : width;
+}
+
+static void mark_dirty(TextEditor *editor, int first, int last) {
+  if (first < editor->dirty_first)
+    editor->dirty_first = first;
+  if (last > editor->dirty_last)
+    editor->dirty_last = last;
+}
+
+// Makes room for `capacity` characters. A line holds at least one character,
+// plus the empty one after a full last line, so the line arrays are sized
+// here once and a re-wrap never allocates.
+static bool reserve(TextEditor *editor, int capacity) {
+  if (capacity <= editor->capacity)
+    return true;
+  wchar_t *text = ordo_malloc(sizeof(wchar_t) * (size_t)capacity);
+  int *line_starts =
+      ordo_realloc(editor->line_starts, sizeof(int) * (size_t)(capacity + 1));
+  if (line_starts)
+    editor->line_starts = line_starts;
+  int *wrap_starts =
+      ordo_realloc(editor->wrap_starts, sizeof(int) * (size_t)(capacity + 1));
+  if (wrap_starts)
+    editor->wrap_starts = wrap_starts;
+  if (!text || !line_starts || !wrap_starts) {
+    free(text);
+    return false;
+  }
+
+  int after_gap = editor->capacity - editor->gap_end;
+  if (editor->text) {
+    memcpy(text, editor->text, sizeof(wchar_t) * (size_t)editor->gap_start);
+    memcpy(text + capacity - after_gap, editor->text + editor->gap_end,
+           sizeof(wchar_t) * (size_t)after_gap);
+    free(editor->text);
+  }
+  editor->text = text;
+  editor->gap_end = capacity - after_gap;
+  editor->capacity = capacity;
+  return true;
+}
+
+// Moves the gap to a position of the text, moving only the characters in
+// between.
+static void move_gap(TextEditor *editor, int position) {
+  if (position < editor->gap_start) {
+    int count = editor->gap_start - position;
+    memmove(editor->text + editor->gap_end - count, editor->text + position,
+            sizeof(wchar_t) * (size_t)count);
+    editor->gap_start -= count;
+    editor->gap_end -= count;
+  } else if (position > editor->gap_start) {
+    int count = position - editor->gap_start;
+    memmove(editor->text + editor->gap_start, editor->text + editor->gap_end,
+            sizeof(wchar_t) * (size_t)count);
+    editor->gap_start += count;
+    editor->gap_end += count;
+  }
+}
+
+// Updates the line index after `removed` characters at `position` were
+// replaced by `added` others. Wrapping restarts at the line before the
+// change, which a narrower character may now let take more, and stops as
+// soon as a line starts where one did before: from there on the text and so
+// the layout are the old ones, shifted by the edit.
+static void rewrap(TextEditor *editor, int position, int removed, int added) {
+  int delta = added - removed;
+  int changed_end = position + added;
+  int line = text_editor_line_of(editor, position);
+  if (line > 0)
+    line--;
+
+  // The first old line start that survives the change
+  int old = line + 1;
+  while (old < editor->line_count &&
+         editor->line_starts[old] < position + removed)
+    old++;
+
+  int length = text_editor_length(editor);
+  int count = 0;
+  int column = 0;
+  bool converged = false;
+  for (int i = editor->line_starts[line]; i < length; i++) {
+    int width = char_width(text_editor_char_at(editor, i));
+    if (column + width > editor->width && column > 0) {
+      if (i >= changed_end) {
+        while (old < editor->line_count &&
+               editor->line_starts[old] + delta < i)
+          old++;
+        if (old < editor->line_count && editor->line_starts[old] + delta == i) {
+          converged = true;
+          break;
+        }
+      }
+      editor->wrap_starts[count++] = i;
+      column = 0;
+    }
+    column += width;
+  }
+  // The cursor after a full last line is shown on a line of its own.
+  if (!converged && column >= editor->width)
+    editor->wrap_starts[count++] = length;
+
+  int first_new = line + 1;
+  int tail = converged ? editor->line_count - old : 0;
+  memmove(&editor->line_starts[first_new + count], &editor->line_starts[old],
+          sizeof(int) * (size_t)tail);
+  for (int i = first_new + count; i < first_new + count + tail; i++)
+    editor->line_starts[i] += delta;
+  memcpy(&editor->line_starts[first_new], editor->wrap_starts,
+         sizeof(int) * (size_t)count);
+  editor->line_count = first_new + count + tail;
+
+  // The lines after the change only look the same if they stayed put.
+  bool shifted = !converged || first_new + count != old;
+  mark_dirty(editor, line, shifted ? INT_MAX : first_new + count - 1);
+}
+
+bool text_editor_init(TextEditor *editor, int max_length, int width) {
+  *editor = (TextEditor){.max_length = max_length, .width = width};
+  int capacity = max_length < MIN_EDITOR_CAPACITY ? max_length + 1
+                                                  : MIN_EDITOR_CAPACITY;
+  if (!reserve(editor, capacity)) {
+    text_editor_free(editor);
+    return false;
+  }
+  editor->line_starts[0] = 0;
+  editor->line_count = 1;
+  text_editor_touch(editor);
+  return true;
+}
+
+void text_editor_free(TextEditor *editor) {
+  free(editor->text);
+  free(editor->line_starts);
+  free(editor->wrap_starts);
+  *editor = (TextEditor){0};
+}
+
+int text_editor_length(const TextEditor *editor) {
+  return editor->capacity - (editor->gap_end - editor->gap_start);
+}
+
+wchar_t text_editor_char_at(const TextEditor *editor, int position) {
+  if (position < editor->gap_start)
+    return editor->text[position];
+  return editor->text[position + editor->gap_end - editor->gap_start];
+}
+
+bool text_editor_insert(TextEditor *editor, wchar_t ch) {
+  int length = text_editor_length(editor);
+  if (length >= editor->max_length)
+    return false;
+  if (editor->gap_start == editor->gap_end) {
+    int capacity = editor->capacity * 2;
+    if (capacity > editor->max_length)
+      capacity = editor->max_length;
+    if (!reserve(editor, capacity))
+      return false;
+  }
+  int position = editor->cursor;
+  move_gap(editor, position);
+  editor->text[editor->gap_start++] = ch;
+  editor->cursor++;
+  rewrap(editor, position, 0, 1);
+  return true;
+}
+
+void text_editor_delete(TextEditor *editor, int from, int to) {
+  int length = text_editor_length(editor);
+  if (from < 0)
+    from = 0;
+  if (to > length)
+    to = length;
+  if (from >= to)
+    return;
+  move_gap(editor, to);
+  editor->gap_start = from;
+  editor->cursor = from;
+  rewrap(editor, from, to - from, 0);
+}
+
+int text_editor_line_of(const TextEditor *editor, int position) {
+  int low = 0, high = editor->line_count - 1;
+  while (low < high) {
+    int mid = low + (high - low + 1) / 2;
+    if (editor->line_starts[mid] <= position)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+  return low;
+}
+
+int text_editor_column_of(const TextEditor *editor, int position) {
+  int line = text_editor_line_of(editor, position);
+  int column = 0;
+  for (int i = editor->line_starts[line]; i < position; i++)
+    column += char_width(text_editor_char_at(editor, i));
+  return column;
+}
+
+int text_editor_position_at(const TextEditor *editor, int line, int column) {
+  int start = editor->line_starts[line];
+  int end = start + text_editor_line_length(editor, line);
+  // The end of a line that wraps is the start of the next one, so the cursor
+  // stops before its last character.
+  if (line + 1 < editor->line_count && end > start)
+    end--;
+  int position = start;
+  for (int x = 0; position < end; position++) {
+    x += char_width(text_editor_char_at(editor, position));
+    if (x > column)
+      break;
+  }
+  return position;
+}
+
+int text_editor_line_length(const TextEditor *editor, int line) {
+  int end = line + 1 < editor->line_count ? editor->line_starts[line + 1]
+                                          : text_editor_length(editor);
+  return end - editor->line_starts[line];
+}
+
+int text_editor_copy_line(const TextEditor *editor, int line, wchar_t *dest) {
+  int start = editor->line_starts[line];
+  int count = text_editor_line_length(editor, line);
+  for (int i = 0; i < count; i++)
+    dest[i] = text_editor_char_at(editor, start + i);
+  return count;
+}
+
+void text_editor_touch(TextEditor *editor) {
+  editor->dirty_first = 0;
+  editor->dirty_last = INT_MAX;
+}
+
+void text_editor_clean(TextEditor *editor) {
+  editor->dirty_first = INT_MAX;
+  editor->dirty_last = -1;
+}
+
+void text_editor_to_mbs(const TextEditor *editor, char *dest,
+                        size_t dest_size) {
+  if (dest_size == 0)
+    return;
+  mbstate_t state = {0};
+  char bytes[MB_LEN_MAX];
+  size_t used = 0;
+  int length = text_editor_length(editor);
+  for (int i = 0; i < length; i++) {
+    size_t count = wcrtomb(bytes, text_editor_char_at(editor, i), &state);
+    if (count == (size_t)-1)
+      continue;
+    if (used + count >= dest_size)
+      break;
+    memcpy(dest + used, bytes, count);
+    used += count;
+  }
+  dest[used] = '\0';
+}
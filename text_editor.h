@@ -0,0 +1,152 @@
+/**
+ * @file text_editor.h
+ * @brief The text model of the description editor: a gap buffer with a line
+ * index.
+ *
+ * The text is held as wide characters in a gap buffer, so inserting or
+ * deleting at the cursor moves nothing but the gap; the gap only travels,
+ * once, when an edit happens away from where the previous one did.
+ *
+ * The text is wrapped into lines of a fixed number of terminal columns, by
+ * display width, so wide (CJK, emoji) and zero-width characters land where
+ * the terminal puts them. The index of line starts is kept up to date
+ * incrementally: an edit re-wraps from the line before it only until the
+ * layout lines up with the old one again. The lines whose content changed
+ * since the last `text_editor_clean` are reported, so the editor widget
+ * repaints only those.
+ */
+
+#ifndef TEXT_EDITOR_H
+#define TEXT_EDITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <wchar.h>
+
+/**
+ * @struct TextEditor
+ * @brief A wrapped, editable text and its cursor.
+ */
+typedef struct {
+  wchar_t *text;     /**< The text is `[0, gap_start)` followed by `[gap_end, capacity)`. */
+  int capacity;      /**< The capacity of `text`, in characters. */
+  int gap_start;     /**< Where the gap starts. */
+  int gap_end;       /**< Where the text after the gap resumes. */
+  int max_length;    /**< The longest text accepted, in characters. */
+  int cursor;        /**< The cursor, as the position of the character after it. */
+  int width;         /**< The columns of a line. */
+  int *line_starts;  /**< The position of each line's first character; there is always one line. */
+  int line_count;    /**< The number of lines. */
+  int *wrap_starts;  /**< Where a re-wrap collects the new line starts. */
+  int dirty_first;   /**< The first line changed since the last `text_editor_clean`. */
+  int dirty_last;    /**< The last one; `dirty_first > dirty_last` if none changed. */
+} TextEditor;
+
+/**
+ * @brief Initializes an empty editor. Every line starts out dirty.
+ * @param[out] editor Pointer to the `TextEditor` to be initialized.
+ * @param[in] max_length The longest text accepted, in characters.
+ * @param[in] width The columns of a line.
+ * @return `false` if memory allocation fails.
+ */
+bool text_editor_init(TextEditor *editor, int max_length, int width);
+
+/**
+ * @brief Frees the memory of an editor.
+ * @param[in] editor Pointer to the `TextEditor`.
+ */
+void text_editor_free(TextEditor *editor);
+
+/**
+ * @brief Returns the length of the text, in characters.
+ * @param[in] editor Pointer to the `TextEditor`.
+ */
+int text_editor_length(const TextEditor *editor);
+
+/**
+ * @brief Returns the character at a position of the text.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] position A position below `text_editor_length`.
+ */
+wchar_t text_editor_char_at(const TextEditor *editor, int position);
+
+/**
+ * @brief Inserts a character at the cursor and moves the cursor past it.
+ * @param[in,out] editor Pointer to the `TextEditor`.
+ * @param[in] ch The character.
+ * @return `false` if the text is at its maximum length or memory ran out.
+ */
+bool text_editor_insert(TextEditor *editor, wchar_t ch);
+
+/**
+ * @brief Deletes the characters in `[from, to)` and puts the cursor at `from`.
+ * @param[in,out] editor Pointer to the `TextEditor`.
+ * @param[in] from The first position deleted.
+ * @param[in] to The position after the last one deleted.
+ */
+void text_editor_delete(TextEditor *editor, int from, int to);
+
+/**
+ * @brief Returns the line a position of the text is shown on.
+ *
+ * A position at the start of a line belongs to that line, not to the end of
+ * the previous one; the end of a full last line starts a line of its own.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] position A position from 0 to `text_editor_length`.
+ */
+int text_editor_line_of(const TextEditor *editor, int position);
+
+/**
+ * @brief Returns the column, within its line, of a position of the text.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] position A position from 0 to `text_editor_length`.
+ */
+int text_editor_column_of(const TextEditor *editor, int position);
+
+/**
+ * @brief Finds the position of a line shown at a column, or the end of the
+ * line if it is shorter.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] line A line below `line_count`.
+ * @param[in] column The column.
+ */
+int text_editor_position_at(const TextEditor *editor, int line, int column);
+
+/**
+ * @brief Copies the characters of a line.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] line A line below `line_count`.
+ * @param[out] dest Receives the characters, without a terminator. It must hold
+ * `text_editor_line_length` characters.
+ * @return The number of characters copied.
+ */
+int text_editor_copy_line(const TextEditor *editor, int line, wchar_t *dest);
+
+/**
+ * @brief Returns the number of characters of a line.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[in] line A line below `line_count`.
+ */
+int text_editor_line_length(const TextEditor *editor, int line);
+
+/**
+ * @brief Marks every line as changed, e.g. after the widget was covered.
+ * @param[in,out] editor Pointer to the `TextEditor`.
+ */
+void text_editor_touch(TextEditor *editor);
+
+/**
+ * @brief Forgets the changed lines, once they were repainted.
+ * @param[in,out] editor Pointer to the `TextEditor`.
+ */
+void text_editor_clean(TextEditor *editor);
+
+/**
+ * @brief Converts the text to a multibyte string.
+ * @param[in] editor Pointer to the `TextEditor`.
+ * @param[out] dest The destination; the text is cut if it does not fit.
+ * @param[in] dest_size The size of `dest`, in bytes.
+ */
+void text_editor_to_mbs(const TextEditor *editor, char *dest, size_t dest_size);
+
+#endif // TEXT_EDITOR_H
@@ -2,8 +2,11 @@
 #include "utils.h"
 #include "ui.h"
 #include "i18n.h"
+#include "text_editor.h"
+#include "utf8_width.h"
 #include "utils.h"
 #include <ctype.h>
+#include <limits.h>
 #include <ncurses.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,9 +16,188 @@
 WINDOW *sidebar_win, *content_win, *status_win;
 #define SIDEBAR_WIDTH 30
 
+// --- Retained State ---
+// What the windows show at the moment, so that a frame repaints only the
+// parts whose content changed.
+
+// A row of the task list as it was last drawn
+typedef struct {
+  int id;              // The task on the row, -1 for a blank row, or
+                       // DRAWN_UNKNOWN if the row must be repainted
+  const char *text;    // Its description, as stored in the list
+  int concluida;
+  bool marked;
+  bool selected;
+} DrawnRow;
+
+#define DRAWN_UNKNOWN -2
+
+static unsigned int dirty_regions = UI_REGION_ALL;
+static int layout_h = -1, layout_w = -1;
+
+static AppView drawn_menu_view;
+static char drawn_clock[16];
+
+static struct {
+  const TaskList *list;     // The list the rows were drawn from
+  unsigned long generation; // Its generation at the time
+  char title[200];          // The title and counts on the top border
+  char counts[100];
+  bool empty;               // Whether the empty-list message is shown
+  int bar_y, bar_h;         // The scrollbar (0 rows if none), or -1 if
+                            // it must be repainted
+  DrawnRow *rows;           // One per content row
+  int row_count;
+} drawn_tasks;
+
+// --- Row Cache ---
+// The text of the task rows drawn recently: a status prefix and the
+// description, converted to a wide string and cut to the row's width, so that
+// a row shown again is drawn without converting or measuring anything. An
+// entry is found by task ID and stays valid while the description and the
+// width are the same; the prefix is written into it on every draw.
+#define ROW_CACHE_SIZE 512 // A power of two; consecutive IDs never collide
+#define ROW_PREFIX_LEN 3   // Mark, status icon and a space
+
+typedef struct {
+  int id;
+  int width;                // The columns the description was cut to
+  unsigned long generation; // With `text`, where the description was last seen
+  const char *text;
+  char *source;             // A copy of the description
+  wchar_t *line;            // The prefix, then the cut description; NULL if
+                            // the entry is unused
+} RowCacheEntry;
+
+static RowCacheEntry row_cache[ROW_CACHE_SIZE];
+
+// Returns the row text of a task whose description gets `width` columns, or
+// NULL if memory ran out.
+static wchar_t *row_cache_line(const TaskList *list, const Task *task,
+                               int width) {
+  RowCacheEntry *entry =
+      &row_cache[(unsigned int)task->id & (ROW_CACHE_SIZE - 1)];
+  if (entry->line && entry->id == task->id && entry->width == width) {
+    if (entry->generation == list->generation &&
+        entry->text == task->descricao)
+      return entry->line;
+    // Reloaded, or edited: only the text itself tells.
+    if (strcmp(entry->source, task->descricao) == 0) {
+      entry->generation = list->generation;
+      entry->text = task->descricao;
+      return entry->line;
+    }
+  }
+
+  size_t len = strlen(task->descricao);
+  char *source = ordo_malloc(len + 1);
+  wchar_t *line = ordo_malloc(sizeof(wchar_t) * (ROW_PREFIX_LEN + len + 4));
+  if (!source || !line) {
+    free(source);
+    free(line);
+    return NULL;
+  }
+  safe_memcpy(source, task->descricao, len + 1);
+  wide_truncate_by_width(line + ROW_PREFIX_LEN, len + 4, task->descricao,
+                         width);
+  free(entry->source);
+  free(entry->line);
+  *entry = (RowCacheEntry){task->id, width, list->generation,
+                           task->descricao, source, line};
+  return line;
+}
+
+static void row_cache_free(void) {
+  for (int i = 0; i < ROW_CACHE_SIZE; ++i) {
+    free(row_cache[i].source);
+    free(row_cache[i].line);
+    row_cache[i] = (RowCacheEntry){0};
+  }
+}
+
+// --- Wrap Cache ---
+// The lines of the descriptions shown in the full-task view, by task ID and
+// width, so that a long note opened again is not wrapped again. An entry
+// keeps its own copy of the description, which the lines point into, and
+// stays valid while the task's description is the same.
+#define WRAP_CACHE_SIZE 16 // A power of two
+
+typedef struct {
+  int id;
+  int width;       // The columns the lines were wrapped to
+  char *source;    // A copy of the description; NULL if the entry is unused
+  TextSpan *spans; // The lines, as byte ranges of `source`
+  int count;
+} WrapCacheEntry;
+
+static WrapCacheEntry wrap_cache[WRAP_CACHE_SIZE];
+
+// Returns the description of a task wrapped to `width` columns, or NULL if
+// memory ran out.
+static const WrapCacheEntry *wrap_cache_lines(const Task *task, int width) {
+  WrapCacheEntry *entry =
+      &wrap_cache[(unsigned int)task->id & (WRAP_CACHE_SIZE - 1)];
+  if (entry->source && entry->id == task->id && entry->width == width &&
+      strcmp(entry->source, task->descricao) == 0)
+    return entry;
+
+  char *source = ordo_strdup(task->descricao);
+  TextSpan *spans = NULL;
+  int count = source ? wrap_text(source, width, &spans) : -1;
+  if (count < 0) {
+    free(source);
+    return NULL;
+  }
+  free(entry->source);
+  free(entry->spans);
+  *entry = (WrapCacheEntry){task->id, width, source, spans, count};
+  return entry;
+}
+
+static void wrap_cache_free(void) {
+  for (int i = 0; i < WRAP_CACHE_SIZE; ++i) {
+    free(wrap_cache[i].source);
+    free(wrap_cache[i].spans);
+    wrap_cache[i] = (WrapCacheEntry){0};
+  }
+}
+
+void ui_invalidate(unsigned int regions) {
+  dirty_regions |= regions;
+  // The cells are repainted from scratch, so the terminal must not be
+  // trusted to hold what ncurses believes it holds.
+  if (regions == UI_REGION_ALL)
+    clearok(curscr, TRUE);
+}
+
+// Makes the windows under a closed popup show again on the next update.
+static void restore_layout(void) {
+  touchwin(sidebar_win);
+  touchwin(content_win);
+  touchwin(status_win);
+}
+
+// Translation keys of the task list views, indexed by TaskViewKind
+static const char *const view_name_keys[TASK_VIEW_COUNT] = {
+    "LIST_VIEW_ALL", "LIST_VIEW_PENDING", "LIST_VIEW_DONE",
+    "LIST_VIEW_BY_DESCRIPTION", "LIST_VIEW_BY_STATUS"};
+
+const char *ui_view_name_key(TaskViewKind kind) {
+  return view_name_keys[kind];
+}
+
 // --- Lifecycle Functions ---
-void ui_init(const AppConfig *config) {
-  initscr();
+
+// The virtual screen of headless mode, and the input it reads from; NULL when
+// drawing on the terminal.
+static SCREEN *headless_screen;
+static FILE *headless_input;
+
+// Terminal descriptions tried for the virtual screen, most capable first
+static const char *const headless_terms[] = {"xterm-256color", "xterm",
+                                             "vt100"};
+
+static void setup_screen(const AppConfig *config) {
   cbreak();
   noecho();
   keypad(stdscr, TRUE);
@@ -24,19 +206,116 @@ void ui_init(const AppConfig *config) {
   curs_set(0);
   mousemask(ALL_MOUSE_EVENTS | REPORT_MOUSE_POSITION, NULL);
   define_key("\x1b[<", 27); // Enable xterm mouse reporting mode
+  ui_draw_layout();
+}
+
+void ui_init(const AppConfig *config) {
+  initscr();
+  setup_screen(config);
+}
+
+bool ui_init_headless(const AppConfig *config, int lines, int cols,
+                      FILE *sink) {
+#ifdef _WIN32
+  headless_input = fopen("NUL", "r");
+#else
+  headless_input = fopen("/dev/null", "r");
+#endif
+  if (!headless_input)
+    return false;
+  // The size comes from the caller, not from the environment or the sink.
+  use_env(FALSE);
+  for (size_t i = 0; !headless_screen && i < sizeof(headless_terms) /
+                                                 sizeof(headless_terms[0]);
+       i++)
+    headless_screen = newterm(headless_terms[i], sink, headless_input);
+  if (!headless_screen) {
+    fclose(headless_input);
+    headless_input = NULL;
+    return false;
+  }
+  resize_term(lines, cols);
+  setup_screen(config);
+  return true;
 }
 
 void ui_destroy() {
   delwin(sidebar_win);
   delwin(content_win);
   delwin(status_win);
+  sidebar_win = content_win = status_win = NULL;
+  free(drawn_tasks.rows);
+  drawn_tasks.rows = NULL;
+  drawn_tasks.row_count = 0;
+  row_cache_free();
+  wrap_cache_free();
   endwin();
+  layout_h = layout_w = -1;
+  dirty_regions = UI_REGION_ALL;
+  if (headless_screen) {
+    delscreen(headless_screen);
+    fclose(headless_input);
+    headless_screen = NULL;
+    headless_input = NULL;
+  }
+}
+
+// The line-drawing characters ncurses draws in the alternate character set,
+// and what they show
+static const char alternate_keys[] = "lkmjqxtuvwna0~";
+static const wchar_t alternate_chars[] = L"┌┐└┘─│├┤┴┬┼▒█·";
+
+char *ui_snapshot(void) {
+  int lines, cols;
+  getmaxyx(curscr, lines, cols);
+  // A cell holds a character and up to CCHARW_MAX - 1 combining marks.
+  size_t row_size = (size_t)cols * CCHARW_MAX * MB_LEN_MAX + 1;
+  size_t size = (size_t)lines * row_size + 1;
+  char *text = ordo_malloc(size);
+  if (!text)
+    return NULL;
+
+  size_t used = 0;
+  mbstate_t state = {0};
+  for (int y = 0; y < lines; y++) {
+    bool right_half = false;
+    for (int x = 0; x < cols; x++) {
+      cchar_t cell;
+      wchar_t chars[CCHARW_MAX + 1] = {0};
+      attr_t attrs;
+      short pair;
+      const char *key;
+      if (mvwin_wch(curscr, y, x, &cell) == ERR ||
+          getcchar(&cell, chars, &attrs, &pair, NULL) == ERR || !chars[0])
+        chars[0] = L' ';
+      else if ((attrs & A_ALTCHARSET) && chars[0] > 0 && chars[0] < 0x80 &&
+               (key = strchr(alternate_keys, (int)chars[0])))
+        chars[0] = alternate_chars[key - alternate_keys];
+      // The right half of a wide character repeats it, followed by the
+      // zero-width characters that came after it.
+      for (int i = right_half ? 1 : 0; chars[i]; i++) {
+        size_t count = wcrtomb(text + used, chars[i], &state);
+        if (count != (size_t)-1)
+          used += count;
+      }
+      right_half =
+          !right_half && utf8_codepoint_width((uint32_t)chars[0]) == 2;
+    }
+    text[used++] = '\n';
+  }
+  text[used] = '\0';
+  return text;
 }
 
 // --- Drawing and Layout Functions ---
+
+// Creates the windows on the first call and again whenever the terminal size
+// changed; otherwise the windows, and what they show, are kept.
 void ui_draw_layout() {
   int screen_h, screen_w;
   getmaxyx(stdscr, screen_h, screen_w);
+  if (sidebar_win && screen_h == layout_h && screen_w == layout_w)
+    return;
   if (sidebar_win)
     delwin(sidebar_win);
   if (content_win)
@@ -47,29 +326,43 @@ void ui_draw_layout() {
   content_win =
       newwin(screen_h - 1, screen_w - SIDEBAR_WIDTH, 0, SIDEBAR_WIDTH);
   status_win = newwin(1, screen_w, screen_h - 1, 0);
-  box(sidebar_win, 0, 0);
-  box(content_win, 0, 0);
+  layout_h = screen_h;
+  layout_w = screen_w;
+
+  int content_h = getmaxy(content_win) - 2;
+  DrawnRow *rows =
+      ordo_realloc(drawn_tasks.rows,
+                   sizeof(DrawnRow) * (size_t)(content_h > 0 ? content_h : 1));
+  if (rows) {
+    drawn_tasks.rows = rows;
+    drawn_tasks.row_count = content_h > 0 ? content_h : 0;
+  } else {
+    drawn_tasks.row_count = 0; // Rows past the kept array are skipped
+  }
   wnoutrefresh(stdscr);
-  wnoutrefresh(sidebar_win);
-  wnoutrefresh(content_win);
-  wnoutrefresh(status_win);
+  ui_invalidate(UI_REGION_ALL);
 }
 
 void ui_display_menu(WINDOW *win, const AppConfig *config,
                      AppView current_view) {
-  wclear(win);
+  if (!(dirty_regions & UI_REGION_MENU) && current_view == drawn_menu_view) {
+    wnoutrefresh(win); // Unchanged
+    return;
+  }
+  dirty_regions &= ~UI_REGION_MENU;
+  dirty_regions |= UI_REGION_CLOCK; // Erased along with the menu
+  drawn_menu_view = current_view;
+  werase(win);
   box(win, 0, 0);
-  wchar_t wide_buffer[256];
   char str_buffer[256];
   char truncated_buffer[256];
 
-  const char *title = (current_view == VIEW_MAIN) ? "APP_TITLE" : "TRASH_TITLE";
-  mbstowcs(wide_buffer, get_translation(title), 256);
+  const char *title = get_translation(
+      (current_view == VIEW_MAIN) ? "APP_TITLE" : "TRASH_TITLE");
 
   // Apply header color
   wattron(win, COLOR_PAIR(config->color_pair_header));
-  mvwaddwstr(win, 1, (SIDEBAR_WIDTH - wcswidth(wide_buffer, -1)) / 2,
-             wide_buffer);
+  mvwaddstr(win, 1, (SIDEBAR_WIDTH - str_width(title)) / 2, title);
   wattroff(win, COLOR_PAIR(config->color_pair_header));
 
   mvwaddwstr(win, 2, 1, L"────────────────────────────");
@@ -78,8 +371,10 @@ void ui_display_menu(WINDOW *win, const AppConfig *config,
     const char *menu_items[] = {
         "MENU_ADD",    "MENU_REMOVE", "MENU_EDIT",   "MENU_TOGGLE",
         "MENU_VIEW",   "MENU_SETTINGS", "MENU_UNDO",   "MENU_REDO",
-        "MENU_TRASH",  "MENU_EXIT"};
-    const char *keys[] = {"1", "2", "3", "4", "5", "6", "u", "y", "t", "7"};
+        "MENU_MARK",   "MENU_SEARCH", "MENU_LIST_VIEW", "MENU_TRASH",
+        "MENU_EXIT"};
+    const char *keys[] = {"1", "2", "3", "4", "5", "6", "u",
+                          "y", "m", "/", "f", "t", "7"};
     for (size_t i = 0; i < sizeof(menu_items) / sizeof(menu_items[0]); ++i) {
       int len = safe_snprintf(str_buffer, sizeof(str_buffer), "[%s] %s", keys[i],
                get_translation(menu_items[i]));
@@ -88,13 +383,13 @@ void ui_display_menu(WINDOW *win, const AppConfig *config,
       }
       truncate_by_width(truncated_buffer, sizeof(truncated_buffer),
                           str_buffer, SIDEBAR_WIDTH - 4);
-      mbstowcs(wide_buffer, truncated_buffer, 256);
-      mvwaddwstr(win, 4 + i, 2, wide_buffer);
+      mvwaddstr(win, 4 + i, 2, truncated_buffer);
     }
   } else { // VIEW_TRASH
     const char *menu_items[] = {"MENU_RESTORE", "MENU_PERM_DELETE",
-                                "MENU_BACK"};
-    const char *keys[] = {"r", "d", "q"};
+                                "MENU_MARK", "MENU_SEARCH",
+                                "MENU_LIST_VIEW", "MENU_BACK"};
+    const char *keys[] = {"r", "d", "m", "/", "f", "q"};
     for (size_t i = 0; i < sizeof(menu_items) / sizeof(menu_items[0]); ++i) {
       int len = safe_snprintf(str_buffer, sizeof(str_buffer), "[%s] %s", keys[i],
                get_translation(menu_items[i]));
@@ -103,83 +398,200 @@ void ui_display_menu(WINDOW *win, const AppConfig *config,
       }
       truncate_by_width(truncated_buffer, sizeof(truncated_buffer),
                           str_buffer, SIDEBAR_WIDTH - 4);
-      mbstowcs(wide_buffer, truncated_buffer, 256);
-      mvwaddwstr(win, 4 + i, 2, wide_buffer);
+      mvwaddstr(win, 4 + i, 2, truncated_buffer);
     }
   }
 
   wnoutrefresh(win);
 }
 
-void ui_display_tasks(WINDOW *win, const Task *tasks, int num_tasks,
-                      const AppConfig *config, int scroll_offset,
-                      int current_selection, AppView current_view) {
-  
-  wclear(win);
-  box(win, 0, 0);
+// Repaints one content row, between the left border and the scrollbar.
+static void draw_task_row(WINDOW *win, int y, int win_w, const TaskList *list,
+                          const Task *task, bool marked, bool selected,
+                          const AppConfig *config) {
+  mvwhline(win, y, 1, ' ', win_w - 3);
+  if (!task)
+    return; // Blank row
 
-  // Add content window title
-  const char *title_key =
-      (current_view == VIEW_MAIN) ? "TASKS_TITLE" : "TRASH_TITLE";
-  wchar_t wide_title[100];
-  mbstowcs(wide_title, get_translation(title_key), 100);
+  wchar_t status_icon = task->concluida ? L'✔' : L'○';
+  int icon_width = utf8_codepoint_width((uint32_t)status_icon) > 0
+                       ? utf8_codepoint_width((uint32_t)status_icon)
+                       : 1;
+  wchar_t *line = row_cache_line(list, task, win_w - 4 - 2 - icon_width);
+  if (!line)
+    return;
+  line[0] = marked ? L'*' : L' ';
+  line[1] = status_icon;
+  line[2] = L' ';
+
+  // Set the color pair based on the task status
+  short color_pair = task->concluida ? config->color_pair_task_done
+                                     : config->color_pair_task_pending;
+  wattron(win, COLOR_PAIR(color_pair));
+  if (selected)
+    wattron(win, A_REVERSE);
+  if (marked)
+    wattron(win, A_BOLD);
+  mvwaddwstr(win, y, 2, line);
+  wattroff(win, A_REVERSE | A_BOLD);
+  wattroff(win, COLOR_PAIR(color_pair));
+}
+
+// Redraws the top border with the title and the per-status counts.
+static void draw_tasks_title(WINDOW *win, int win_w, const char *title,
+                             const char *counts, const AppConfig *config) {
+  mvwhline(win, 0, 1, ACS_HLINE, win_w - 2);
+
+  int title_width = str_width(title);
 
   // Apply header color to the title
   wattron(win, COLOR_PAIR(config->color_pair_header));
-  mvwaddwstr(win, 0, 3, L" ");
-  mvwaddwstr(win, 0, 4, wide_title);
-  mvwaddwstr(win, 0, 4 + wcswidth(wide_title, -1), L" ");
+  mvwaddstr(win, 0, 3, " ");
+  mvwaddstr(win, 0, 4, title);
+  mvwaddstr(win, 0, 4 + title_width, " ");
   wattroff(win, COLOR_PAIR(config->color_pair_header));
 
+  if (counts[0] == '\0')
+    return;
+  int counts_width = str_width(counts);
+  int counts_x = win_w - counts_width - 4;
+  if (counts_x > 6 + title_width) {
+    wattron(win, COLOR_PAIR(config->color_pair_header));
+    mvwaddstr(win, 0, counts_x, " ");
+    mvwaddstr(win, 0, counts_x + 1, counts);
+    mvwaddstr(win, 0, counts_x + 1 + counts_width, " ");
+    wattroff(win, COLOR_PAIR(config->color_pair_header));
+  }
+}
+
+void ui_display_tasks(WINDOW *win, const TaskList *list,
+                      const TaskMarks *marks, const AppConfig *config,
+                      int scroll_offset, int current_selection,
+                      AppView current_view) {
+  int num_tasks = task_list_total(list);
   int win_h, win_w;
   getmaxyx(win, win_h, win_w);
   int content_h = win_h - 2;
-  if (num_tasks == 0) {
-    const char *empty_msg_key =
-        (current_view == VIEW_MAIN) ? "TASK_LIST_EMPTY" : "TRASH_EMPTY";
-    wchar_t wide_buffer[100];
-    mbstowcs(wide_buffer, get_translation(empty_msg_key), 100);
-    mvwaddwstr(win, content_h / 2, (win_w - wcswidth(wide_buffer, -1)) / 2,
-               wide_buffer);
+
+  // Start over when asked to or when the list was reloaded: descriptions of
+  // an earlier generation may share an address with the current ones.
+  if ((dirty_regions & UI_REGION_TASKS) || list != drawn_tasks.list ||
+      list->generation != drawn_tasks.generation) {
+    dirty_regions &= ~UI_REGION_TASKS;
+    drawn_tasks.list = list;
+    drawn_tasks.generation = list->generation;
+    drawn_tasks.title[0] = '\0';
+    drawn_tasks.empty = false;
+    drawn_tasks.bar_y = drawn_tasks.bar_h = -1;
+    for (int i = 0; i < drawn_tasks.row_count; ++i)
+      drawn_tasks.rows[i].id = DRAWN_UNKNOWN;
+    werase(win);
+    box(win, 0, 0);
+  }
+
+  // Add content window title
+  const char *title_key =
+      (current_view == VIEW_MAIN) ? "TASKS_TITLE" : "TRASH_TITLE";
+  char title[200];
+  if (list->view == TASK_VIEW_ALL) {
+    safe_snprintf(title, sizeof(title), "%s", get_translation(title_key));
   } else {
-    for (int i = 0; i < content_h && (scroll_offset + i) < num_tasks; ++i) {
-      int task_index = scroll_offset + i;
-
-      // Set the color pair based on the task status
-      short color_pair = tasks[task_index].concluida
-                             ? config->color_pair_task_done
-                             : config->color_pair_task_pending;
-      wattron(win, COLOR_PAIR(color_pair));
-
-      const char *status_icon = tasks[task_index].concluida ? "✔" : "○";
-      char task_line[win_w];
-      safe_snprintf(task_line, sizeof(task_line), " %s %s", status_icon,
-               tasks[task_index].descricao);
-      char truncated_line[win_w];
-      truncate_by_width(truncated_line, sizeof(truncated_line), task_line,
-                          win_w - 4);
-      wchar_t wide_task[win_w];
-      mbstowcs(wide_task, truncated_line, win_w);
-      if (task_index == current_selection)
-        wattron(win, A_REVERSE);
-      mvwaddwstr(win, i + 1, 2, wide_task);
-      if (task_index == current_selection)
-        wattroff(win, A_REVERSE);
-
-      wattroff(win, COLOR_PAIR(color_pair));
+    safe_snprintf(title, sizeof(title), "%s · %s", get_translation(title_key),
+                  get_translation(view_name_keys[list->view]));
+  }
+
+  // Per-status counts, read from the status bitset. A windowed list only
+  // holds part of the view, so they are left out.
+  char counts[100] = "";
+  if (!list->windowed && list->count > 0) {
+    safe_snprintf(counts, sizeof(counts), get_translation("TASK_COUNTS"),
+                  task_list_count_status(list, 0),
+                  task_list_count_status(list, 1));
+  }
+  if (strcmp(title, drawn_tasks.title) != 0 ||
+      strcmp(counts, drawn_tasks.counts) != 0) {
+    safe_snprintf(drawn_tasks.title, sizeof(drawn_tasks.title), "%s", title);
+    safe_snprintf(drawn_tasks.counts, sizeof(drawn_tasks.counts), "%s",
+                  counts);
+    draw_tasks_title(win, win_w, title, counts, config);
+  }
+
+  if (num_tasks == 0) {
+    if (!drawn_tasks.empty) {
+      const char *empty_msg_key =
+          list->view != TASK_VIEW_ALL ? "LIST_VIEW_EMPTY"
+          : (current_view == VIEW_MAIN) ? "TASK_LIST_EMPTY"
+                                        : "TRASH_EMPTY";
+      for (int y = 1; y <= content_h; ++y)
+        mvwhline(win, y, 1, ' ', win_w - 2);
+      const char *empty_msg = get_translation(empty_msg_key);
+      mvwaddstr(win, content_h / 2, (win_w - str_width(empty_msg)) / 2,
+                empty_msg);
+      drawn_tasks.empty = true;
+      drawn_tasks.bar_y = drawn_tasks.bar_h = -1;
+      for (int i = 0; i < drawn_tasks.row_count; ++i)
+        drawn_tasks.rows[i].id = DRAWN_UNKNOWN;
     }
-    if (num_tasks > content_h) {
-      int bar_h = (int)((float)content_h / num_tasks * content_h);
-      if (bar_h < 1)
-        bar_h = 1;
-      int bar_y = (int)((float)scroll_offset / num_tasks * content_h) + 1;
-      for (int i = 0; i < bar_h; ++i)
-        mvwaddch(win, bar_y + i, win_w - 2, ACS_BLOCK);
+    wnoutrefresh(win);
+    return;
+  }
+  if (drawn_tasks.empty) {
+    // The message spans the rows; wipe it before drawing them.
+    for (int y = 1; y <= content_h; ++y)
+      mvwhline(win, y, 1, ' ', win_w - 2);
+    drawn_tasks.empty = false;
+  }
+
+  // Walk the visible rows with a cursor, which steps over the list's
+  // tombstones instead of looking up every position. A row is repainted only
+  // if what it shows differs from the last frame.
+  TaskListCursor cursor = task_list_seek(list, scroll_offset);
+  for (int i = 0; i < content_h && i < drawn_tasks.row_count;
+       ++i, task_list_advance(list, &cursor)) {
+    const Task *task = cursor.position < num_tasks && cursor.index >= 0
+                           ? &list->tasks[cursor.index]
+                           : NULL; // Past the end, or outside the window
+    DrawnRow row = {-1, NULL, 0, false, false};
+    if (task) {
+      row.id = task->id;
+      row.text = task->descricao;
+      row.concluida = task->concluida;
+      row.marked = task_marks_contains(marks, task->id);
+      row.selected = (cursor.position == current_selection);
     }
+    DrawnRow *drawn = &drawn_tasks.rows[i];
+    if (drawn->id == row.id && drawn->text == row.text &&
+        drawn->concluida == row.concluida && drawn->marked == row.marked &&
+        drawn->selected == row.selected)
+      continue;
+    *drawn = row;
+    draw_task_row(win, i + 1, win_w, list, task, row.marked, row.selected,
+                  config);
+  }
+
+  int bar_y = 0, bar_h = 0;
+  if (num_tasks > content_h) {
+    bar_h = (int)((float)content_h / num_tasks * content_h);
+    if (bar_h < 1)
+      bar_h = 1;
+    bar_y = (int)((float)scroll_offset / num_tasks * content_h) + 1;
+  }
+  if (bar_y != drawn_tasks.bar_y || bar_h != drawn_tasks.bar_h) {
+    mvwvline(win, 1, win_w - 2, ' ', content_h);
+    for (int i = 0; i < bar_h; ++i)
+      mvwaddch(win, bar_y + i, win_w - 2, ACS_BLOCK);
+    drawn_tasks.bar_y = bar_y;
+    drawn_tasks.bar_h = bar_h;
   }
   wnoutrefresh(win);
 }
 
+// --- Status Line ---
+// A message or the search prompt starts on the left; the performance overlay
+// takes the right end of what is left.
+static int status_used;    // Columns taken by the message or the prompt
+static int overlay_x = -1; // Where the overlay starts, or -1 if not shown
+
 void ui_show_message(const char *translation_key, bool is_error,
                      const AppConfig *config) {
   werase(status_win);
@@ -188,6 +600,91 @@ void ui_show_message(const char *translation_key, bool is_error,
   wattron(status_win, COLOR_PAIR(color_pair));
   mvwprintw(status_win, 0, 1, "%s", get_translation(translation_key));
   wattroff(status_win, COLOR_PAIR(color_pair));
+  status_used = getcurx(status_win);
+  overlay_x = -1;
+  wnoutrefresh(status_win);
+}
+
+void ui_clear_message() {
+  werase(status_win);
+  status_used = 0;
+  overlay_x = -1;
+  wnoutrefresh(status_win);
+}
+
+void ui_display_perf_overlay(const PerfStats *stats, const AppConfig *config) {
+  static const char *const db_labels[PERF_DB_COUNT] = {"load", "trash",
+                                                        "window", "sync",
+                                                        "search"};
+  if (!stats && overlay_x < 0)
+    return;
+  if (overlay_x >= 0) {
+    wmove(status_win, 0, overlay_x);
+    wclrtoeol(status_win);
+    overlay_x = -1;
+  }
+
+  if (stats) {
+    char text[512];
+    size_t size = sizeof(text);
+    int len = safe_snprintf(text, size, "frame %.2f ms  p99 %.2f ms  ",
+                            (double)stats->frame_ns / 1e6,
+                            (double)stats->frame_p99_ns / 1e6);
+    for (int i = 0; i < PERF_DB_COUNT; i++) {
+      const PerfDbTiming *db = &stats->db[i];
+      if (db->called)
+        len += safe_snprintf(text + len, size - (size_t)len,
+                             "%s %.2f ms/%d  ", db_labels[i],
+                             (double)db->ns / 1e6, db->rows);
+    }
+    len += safe_snprintf(text + len, size - (size_t)len, "alloc %lu  ",
+                         stats->allocations);
+    if (stats->tty_bytes >= 0)
+      len += safe_snprintf(text + len, size - (size_t)len, "tty %ld B  ",
+                           stats->tty_bytes);
+    text[len - 2] = '\0'; // The separator after the last number
+
+    int x = getmaxx(status_win) - (len - 2) - 1;
+    if (x > status_used + 1) {
+      wattron(status_win, COLOR_PAIR(config->color_pair_header));
+      mvwaddstr(status_win, 0, x, text);
+      wattroff(status_win, COLOR_PAIR(config->color_pair_header));
+      overlay_x = x;
+    }
+  }
+  wnoutrefresh(status_win);
+}
+
+void ui_display_search_prompt(const char *query, int match_count,
+                              const AppConfig *config) {
+  werase(status_win);
+  status_used = getmaxx(status_win); // No room for the overlay
+  overlay_x = -1;
+  mvwprintw(status_win, 0, 1, "%s %s", get_translation("SEARCH_PROMPT"), query);
+  int cursor_y, cursor_x;
+  getyx(status_win, cursor_y, cursor_x);
+
+  // Match count on the right, once something has been typed
+  if (query[0] != '\0') {
+    char count[64];
+    bool none = (match_count == 0);
+    if (none) {
+      safe_snprintf(count, sizeof(count), "%s",
+                    get_translation("SEARCH_NO_MATCHES"));
+    } else {
+      safe_snprintf(count, sizeof(count), get_translation("SEARCH_MATCHES"),
+                    match_count);
+    }
+    int x = getmaxx(status_win) - str_width(count) - 1;
+    if (x > cursor_x + 1) {
+      short color_pair =
+          none ? config->color_pair_error : config->color_pair_success;
+      wattron(status_win, COLOR_PAIR(color_pair));
+      mvwprintw(status_win, 0, x, "%s", count);
+      wattroff(status_win, COLOR_PAIR(color_pair));
+    }
+  }
+  wmove(status_win, cursor_y, cursor_x);
   wnoutrefresh(status_win);
 }
 
@@ -198,39 +695,38 @@ static WINDOW *create_popup(int h, int w, const char *title_key) {
   int x = (screen_w - w) / 2;
   WINDOW *win = newwin(h, w, y, x);
   box(win, 0, 0);
-  wchar_t wide_title[100];
-  mbstowcs(wide_title, get_translation(title_key), 100);
-  mvwaddwstr(win, 1, (w - wcswidth(wide_title, -1)) / 2, wide_title);
+  const char *title = get_translation(title_key);
+  mvwaddstr(win, 1, (w - str_width(title)) / 2, title);
   wrefresh(win);
   return win;
 }
 
 // --- Text Manipulation Helper Functions --- // Find the start of the previous word
-static int find_prev_word_start(const wchar_t *str, int current_pos) {
+static int find_prev_word_start(const TextEditor *editor, int current_pos) {
   if (current_pos == 0) return 0;
   int pos = current_pos - 1;
   // Skip whitespace to the left
-  while (pos > 0 && iswspace(str[pos])) {
+  while (pos > 0 && iswspace(text_editor_char_at(editor, pos))) {
     pos--;
   }
   // Skip the word
-  while (pos > 0 && !iswspace(str[pos - 1])) {
+  while (pos > 0 && !iswspace(text_editor_char_at(editor, pos - 1))) {
     pos--;
   }
   return pos;
 }
 
 // Find the start of the next word
-static int find_next_word_start(const wchar_t *str, int current_pos) {
-    int len = wcslen(str);
+static int find_next_word_start(const TextEditor *editor, int current_pos) {
+    int len = text_editor_length(editor);
     if (current_pos >= len) return len;
     int pos = current_pos;
     // Skip the current word
-    while(pos < len && !iswspace(str[pos])) {
+    while(pos < len && !iswspace(text_editor_char_at(editor, pos))) {
         pos++;
     }
     // Skip the current word
-    while(pos < len && iswspace(str[pos])) {
+    while(pos < len && iswspace(text_editor_char_at(editor, pos))) {
         pos++;
     }
     return pos;
@@ -246,130 +742,158 @@ static int find_next_word_start(const wchar_t *str, int current_pos) {
 // Structure to hold the state of the text input widget
 typedef struct {
   WINDOW *win;
-  wchar_t *buffer;
-  int buffer_size;
-  int cursor_pos;
-  int len;
+  TextEditor editor;
   int win_h;
   int win_w;
-  int max_chars_per_line;
+  int rows;     // Lines of text shown; the last row holds the counter
+  int top_line; // First line of text shown
 } TextInputState;
 
-// Draws the text buffer content, counter, and cursor
+// Scrolls the text so the cursor's line is shown. Every row shows another
+// line afterwards.
+static void scroll_to_cursor(TextInputState *state) {
+  int line = text_editor_line_of(&state->editor, state->editor.cursor);
+  int top_line = state->top_line;
+  if (line < top_line)
+    top_line = line;
+  else if (line >= top_line + state->rows)
+    top_line = line - state->rows + 1;
+  if (top_line != state->top_line) {
+    state->top_line = top_line;
+    text_editor_touch(&state->editor);
+  }
+}
+
+// Repaints the rows whose line changed since the last call, then the counter
+// and the cursor
 static void draw_text_input(TextInputState *state) {
-  wclear(state->win);
-  box(state->win, 0, 0);
-
-  // Draws the text with word wrap
-  int current_y = 1, current_x = 1;
-  for (int i = 0; i < state->len; ++i) {
-    if (current_x >= state->max_chars_per_line) {
-      current_y++;
-      current_x = 1;
-    }
-    if (current_y >= state->win_h - 2) break;
-    mvwaddch(state->win, current_y, current_x, state->buffer[i]);
-    current_x++;
+  TextEditor *editor = &state->editor;
+  scroll_to_cursor(state);
+
+  int first = editor->dirty_first - state->top_line;
+  int last = editor->dirty_last - state->top_line;
+  if (first < 0)
+    first = 0;
+  if (last >= state->rows)
+    last = state->rows - 1;
+  for (int row = first; row <= last; row++) {
+    int line = state->top_line + row;
+    mvwhline(state->win, row + 1, 1, ' ', editor->width);
+    if (line >= editor->line_count)
+      continue;
+    wchar_t text[text_editor_line_length(editor, line) + 1];
+    int count = text_editor_copy_line(editor, line, text);
+    mvwaddnwstr(state->win, row + 1, 1, text, count);
   }
+  text_editor_clean(editor);
 
   // Draws the character counter
   char counter[32];
-  safe_snprintf(counter, sizeof(counter), "[%d/%d]", state->len, state->buffer_size - 1);
-  mvwprintw(state->win, state->win_h - 2, state->win_w - strlen(counter) - 2, "%s", counter);
+  safe_snprintf(counter, sizeof(counter), "[%d/%d]",
+                text_editor_length(editor), editor->max_length);
+  int counter_x = state->win_w - (int)strlen(counter) - 2;
+  mvwhline(state->win, state->win_h - 2, 1, ' ', state->win_w - 2);
+  mvwprintw(state->win, state->win_h - 2, counter_x, "%s", counter);
 
   // Positions the cursor
-  int cursor_y = 1 + (state->cursor_pos / state->max_chars_per_line);
-  int cursor_x = 1 + (state->cursor_pos % state->max_chars_per_line);
-  if (cursor_y < state->win_h - 1) {
-    wmove(state->win, cursor_y, cursor_x);
-  }
+  int cursor_line = text_editor_line_of(editor, editor->cursor);
+  wmove(state->win, 1 + cursor_line - state->top_line,
+        1 + text_editor_column_of(editor, editor->cursor));
   wrefresh(state->win);
 }
 
+// Moves the cursor to the line above (`direction` -1) or below (1), keeping
+// its column
+static void move_cursor_line(TextEditor *editor, int direction) {
+  int line = text_editor_line_of(editor, editor->cursor) + direction;
+  if (line < 0)
+    return;
+  if (line >= editor->line_count) {
+    editor->cursor = text_editor_length(editor);
+    return;
+  }
+  int column = text_editor_column_of(editor, editor->cursor);
+  editor->cursor = text_editor_position_at(editor, line, column);
+}
+
 // Processes a single key input and updates the state
 // Returns `false` if editing should end (Enter or Esc), `true` otherwise.
 static bool handle_text_input(TextInputState *state, wint_t ch) {
+  TextEditor *editor = &state->editor;
+  int len = text_editor_length(editor);
   switch (ch) {
   case '\n': // Enter
     return false;
   case 27: // Esc
-    state->buffer[0] = L'\0';
+    text_editor_delete(editor, 0, len);
     return false;
 
   // --- Cursor Movement ---
   case KEY_LEFT:
-    if (state->cursor_pos > 0) state->cursor_pos--;
+    if (editor->cursor > 0) editor->cursor--;
     break;
   case KEY_RIGHT:
-    if (state->cursor_pos < state->len) state->cursor_pos++;
+    if (editor->cursor < len) editor->cursor++;
     break;
   case KEY_UP:
-    if (state->cursor_pos >= state->max_chars_per_line) state->cursor_pos -= state->max_chars_per_line;
+    move_cursor_line(editor, -1);
     break;
   case KEY_DOWN:
-    state->cursor_pos = (state->cursor_pos + state->max_chars_per_line < state->len) ? state->cursor_pos + state->max_chars_per_line : state->len;
+    move_cursor_line(editor, 1);
     break;
   case KEY_HOME:
-    state->cursor_pos = 0;
+    editor->cursor = 0;
     break;
   case KEY_END:
-    state->cursor_pos = state->len;
+    editor->cursor = len;
     break;
   case KEY_CTRL_LEFT:
-    state->cursor_pos = find_prev_word_start(state->buffer, state->cursor_pos);
+    editor->cursor = find_prev_word_start(editor, editor->cursor);
     break;
   case KEY_CTRL_RIGHT:
-    state->cursor_pos = find_next_word_start(state->buffer, state->cursor_pos);
+    editor->cursor = find_next_word_start(editor, editor->cursor);
     break;
 
   // --- Text Editing ---
   case KEY_BACKSPACE:
   case 127:
-    if (state->cursor_pos > 0) {
-      safe_memmove(&state->buffer[state->cursor_pos - 1], &state->buffer[state->cursor_pos], (state->len - state->cursor_pos + 1) * sizeof(wchar_t));
-      state->cursor_pos--;
-    }
+    text_editor_delete(editor, editor->cursor - 1, editor->cursor);
     break;
   case KEY_DC: // Delete
-    if (state->cursor_pos < state->len) {
-      safe_memmove(&state->buffer[state->cursor_pos], &state->buffer[state->cursor_pos + 1], (state->len - state->cursor_pos) * sizeof(wchar_t));
-    }
+    text_editor_delete(editor, editor->cursor, editor->cursor + 1);
     break;
   case KEY_CTRL_BACKSPACE:
-  {
-    int prev_word_start = find_prev_word_start(state->buffer, state->cursor_pos);
-    if (prev_word_start < state->cursor_pos) {
-      safe_memmove(&state->buffer[prev_word_start], &state->buffer[state->cursor_pos], (state->len - state->cursor_pos + 1) * sizeof(wchar_t));
-      state->cursor_pos = prev_word_start;
-    }
+    text_editor_delete(editor, find_prev_word_start(editor, editor->cursor),
+                       editor->cursor);
     break;
-  }
   default:
     // Insert character
-    if (iswprint(ch) && state->len < state->buffer_size - 1) {
-      safe_memmove(&state->buffer[state->cursor_pos + 1], &state->buffer[state->cursor_pos], (state->len - state->cursor_pos + 1) * sizeof(wchar_t));
-      state->buffer[state->cursor_pos] = ch;
-      state->cursor_pos++;
-    }
+    if (iswprint(ch))
+      text_editor_insert(editor, (wchar_t)ch);
     break;
   }
   return true;
 }
 
 // Main text input function, now refactored.
-static void get_editable_input(WINDOW *win, char *buffer, int max_len) {
-  wchar_t w_buffer[max_len];
-  mbstowcs(w_buffer, buffer, max_len);
-
-  TextInputState state;
-  state.win = win;
-  state.buffer = w_buffer;
-  state.buffer_size = max_len;
+// Edits up to `max_chars - 1` characters, stored as a multibyte string in
+// `buffer`, which holds `buffer_size` bytes. The text is kept in a gap
+// buffer, wrapped by display width, and only the lines an edit changed are
+// drawn again.
+static void get_editable_input(WINDOW *win, char *buffer, size_t buffer_size,
+                               int max_chars) {
+  TextInputState state = {.win = win};
   getmaxyx(win, state.win_h, state.win_w);
-  state.max_chars_per_line = state.win_w - 2;
-  state.len = wcslen(w_buffer);
-  state.cursor_pos = state.len;
-  
+  state.rows = state.win_h - 3;
+  if (!text_editor_init(&state.editor, max_chars - 1, state.win_w - 2))
+    return;
+
+  wchar_t w_buffer[max_chars];
+  mbstowcs(w_buffer, buffer, max_chars);
+  w_buffer[max_chars - 1] = L'\0';
+  for (const wchar_t *c = w_buffer; *c; c++)
+    text_editor_insert(&state.editor, *c);
+
   keypad(win, TRUE);
   curs_set(1);
 
@@ -380,21 +904,16 @@ static void get_editable_input(WINDOW *win, char *buffer, int max_len) {
 
   wint_t ch;
   bool keep_editing = true;
-  
-  // The main loop is now much simpler
-  while (keep_editing) {
-    state.len = wcslen(state.buffer);
-    if (state.cursor_pos > state.len) {
-        state.cursor_pos = state.len;
-    }
 
+  while (keep_editing) {
     draw_text_input(&state);
     wget_wch(win, &ch);
     keep_editing = handle_text_input(&state, ch);
   }
 
   curs_set(0);
-  wcstombs(buffer, w_buffer, max_len);
+  text_editor_to_mbs(&state.editor, buffer, buffer_size);
+  text_editor_free(&state.editor);
 }
 
 OrdoResult ui_add_task(const AppConfig *config, char **new_description_out) {
@@ -407,18 +926,19 @@ OrdoResult ui_add_task(const AppConfig *config, char **new_description_out) {
   box(input_win, 0, 0);
   wrefresh(input_win);
 
-  char mb_desc[MAX_DESCRICAO * 4] = {0};
-  get_editable_input(input_win, mb_desc, sizeof(mb_desc));
+  char mb_desc[MAX_DESCRICAO * 4 + 1] = {0};
+  get_editable_input(input_win, mb_desc, sizeof(mb_desc), MAX_DESCRICAO + 1);
 
   delwin(input_win);
   delwin(win);
+  restore_layout();
 
   auto_free_ptr char *trimmed_desc = trim(mb_desc);
   if (!trimmed_desc || strlen(trimmed_desc) == 0) {
     return ORDO_ERROR_EMPTY_DESCRIPTION;
   }
 
-  *new_description_out = strdup(trimmed_desc);
+  *new_description_out = ordo_strdup(trimmed_desc);
   if (!*new_description_out) {
     return ORDO_ERROR_GENERIC;
   }
@@ -437,11 +957,12 @@ OrdoResult ui_edit_task(const AppConfig *config,
   box(input_win, 0, 0);
   wrefresh(input_win);
 
-  char mb_desc[MAX_DESCRICAO * 4] = {0};
-  get_editable_input(input_win, mb_desc, sizeof(mb_desc));
+  char mb_desc[MAX_DESCRICAO * 4 + 1] = {0};
+  get_editable_input(input_win, mb_desc, sizeof(mb_desc), MAX_DESCRICAO + 1);
 
   delwin(input_win);
   delwin(win);
+  restore_layout();
 
   auto_free_ptr char *trimmed_desc = trim(mb_desc);
   if (!trimmed_desc || strlen(trimmed_desc) == 0) {
@@ -449,7 +970,7 @@ OrdoResult ui_edit_task(const AppConfig *config,
   }
 
   // Allocates memory and returns the new description
-  *new_description_out = strdup(trimmed_desc);
+  *new_description_out = ordo_strdup(trimmed_desc);
   if (!*new_description_out) {
     return ORDO_ERROR_GENERIC; // Allocation failure
   }
@@ -466,12 +987,51 @@ bool ui_confirm_action(const char *translation_key, const char *title_key,
   wrefresh(win);
   int choice = wgetch(win);
   delwin(win);
+  restore_layout();
   return (choice == 'y' || choice == 'Y' || choice == 's' || choice == 'S');
 }
 
+#define FULL_TASK_TEXT_Y 8 // First row of the description
+
+// Draws the lines of a wrapped description from `top` on, and where they are
+// in it on the bottom border if it does not fit.
+static void draw_full_task_lines(WINDOW *win, const WrapCacheEntry *wrapped,
+                                 int top, int rows) {
+  int win_h, win_w;
+  getmaxyx(win, win_h, win_w);
+  for (int row = 0; row < rows; ++row) {
+    mvwhline(win, FULL_TASK_TEXT_Y + row, 2, ' ', win_w - 4);
+    if (top + row < wrapped->count) {
+      const TextSpan *line = &wrapped->spans[top + row];
+      mvwaddnstr(win, FULL_TASK_TEXT_Y + row, 2, wrapped->source + line->start,
+                 line->len);
+    }
+  }
+
+  if (wrapped->count > rows) {
+    int last = top + rows < wrapped->count ? top + rows : wrapped->count;
+    char position[48];
+    safe_snprintf(position, sizeof(position), " %d-%d/%d ", top + 1, last,
+                  wrapped->count);
+    mvwhline(win, win_h - 1, 1, ACS_HLINE, win_w - 2);
+    mvwprintw(win, win_h - 1, win_w - (int)strlen(position) - 2, "%s",
+              position);
+  }
+}
+
 void ui_display_full_task(const Task *task, const AppConfig *config) {
   (void)config;
-  int win_h = 15, win_w = 70;
+  int win_w = 70;
+  int max_width = win_w - 4; // 2 for margin + 2 for border
+  const WrapCacheEntry *wrapped = wrap_cache_lines(task, max_width);
+
+  // Tall enough for the whole description, as far as the screen allows
+  int win_h = FULL_TASK_TEXT_Y + 1 + (wrapped ? wrapped->count : 1);
+  if (win_h > LINES - 2)
+    win_h = LINES - 2;
+  if (win_h < 15)
+    win_h = 15;
+  int rows = win_h - FULL_TASK_TEXT_Y - 1;
   WINDOW *win = create_popup(win_h, win_w, "VIEW_TITLE");
 
   char buffer[100];
@@ -485,27 +1045,73 @@ void ui_display_full_task(const Task *task, const AppConfig *config) {
 
   mvwprintw(win, 6, 2, "%s", get_translation("VIEW_FULL_DESC"));
 
-  // Word wrap logic
-  int max_width = win_w - 4; // 2 for margin + 2 for border
-  auto_free_ptr char *wrapped_desc = word_wrap(task->descricao, max_width);
-
-  if (wrapped_desc) {
-    mvwprintw(win, 8, 2, "%s", wrapped_desc);
-  } else {
+  if (!wrapped) {
     // Fallback to the old behavior if allocation fails
     char truncated_desc[MAX_DESCRICAO];
     truncate_by_width(truncated_desc, sizeof(truncated_desc), task->descricao,
                         max_width);
-    mvwprintw(win, 8, 2, "%s", truncated_desc);
+    mvwprintw(win, FULL_TASK_TEXT_Y, 2, "%s", truncated_desc);
+    wrefresh(win);
+    wgetch(win);
+    delwin(win);
+    restore_layout();
+    return;
   }
 
-  wrefresh(win);
-  wgetch(win);
+  // Only the lines shown are drawn, so a long note opens at once. A note
+  // that does not fit scrolls; any other key closes the view.
+  keypad(win, TRUE);
+  int max_top = wrapped->count > rows ? wrapped->count - rows : 0;
+  int top = 0;
+  bool open = true;
+  while (open) {
+    draw_full_task_lines(win, wrapped, top, rows);
+    wrefresh(win);
+    int key = wgetch(win);
+    if (max_top == 0)
+      break;
+    switch (key) {
+    case KEY_UP:
+      top--;
+      break;
+    case KEY_DOWN:
+      top++;
+      break;
+    case KEY_PPAGE:
+      top -= rows;
+      break;
+    case KEY_NPAGE:
+    case ' ':
+      top += rows;
+      break;
+    case KEY_HOME:
+      top = 0;
+      break;
+    case KEY_END:
+      top = max_top;
+      break;
+    default:
+      open = false;
+      break;
+    }
+    if (top < 0)
+      top = 0;
+    if (top > max_top)
+      top = max_top;
+  }
   delwin(win);
+  restore_layout();
 }
 
 void ui_display_clock(WINDOW *win, const char *time_string) {
   if (!win) return;
+  if (!(dirty_regions & UI_REGION_CLOCK) &&
+      strcmp(time_string, drawn_clock) == 0) {
+    wnoutrefresh(win); // Unchanged
+    return;
+  }
+  dirty_regions &= ~UI_REGION_CLOCK;
+  safe_snprintf(drawn_clock, sizeof(drawn_clock), "%s", time_string);
   int win_h, win_w;
   getmaxyx(win, win_h, win_w);
   if (win_w <= 0) return;
@@ -527,12 +1133,12 @@ int ui_handle_sidebar_click(MEVENT event, AppView current_view) {
     if (event.y >= 4) {
         int item_index = event.y - 4;
         if (current_view == VIEW_MAIN) {
-            const char *keys[] = {"1", "2", "3", "4", "5", "6", "u", "y", "t", "7"};
+            const char *keys[] = {"1", "2", "3", "4", "5", "6", "u", "y", "m", "/", "f", "t", "7"};
             if ((size_t)item_index < sizeof(keys) / sizeof(keys[0])) {
                 return keys[item_index][0];
             }
         } else { // VIEW_TRASH
-            const char *keys[] = {"r", "d", "q"};
+            const char *keys[] = {"r", "d", "m", "/", "f", "q"};
             if ((size_t)item_index < sizeof(keys) / sizeof(keys[0])) {
                 return keys[item_index][0];
             }
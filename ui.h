@@ -4,24 +4,60 @@
 #include "app.h" // Includes app.h for AppView
 #include "config.h"
 #include "error.h"
+#include "perf_stats.h"
 #include "task.h"
 #include <ncurses.h> // Includes ncurses for the WINDOW type
 #include <stdbool.h>
+#include <stdio.h>
 
 // --- UI Lifecycle Functions ---
 void ui_init(const AppConfig *config);
 void ui_destroy();
 
+// --- Headless Rendering ---
+// Draws on a virtual screen of `lines` x `cols` instead of the terminal, so
+// that the drawing functions can be timed and their frames compared without
+// a TTY. What would be sent to the terminal is written to `sink`, and input
+// reads as empty except for keys pushed back with ungetch(). Returns false if
+// no terminal description could be loaded. ui_destroy() ends it.
+bool ui_init_headless(const AppConfig *config, int lines, int cols,
+                      FILE *sink);
+
+// The characters on the screen as of the last doupdate(), a line of UTF-8
+// text per row. The caller frees it; NULL if memory ran out.
+char *ui_snapshot(void);
+
+// --- Damage Tracking ---
+// The windows persist between frames and each drawing function repaints only
+// what changed since the previous frame. State the drawing functions cannot
+// see change in, such as the language or the colors, is reported here.
+typedef enum {
+  UI_REGION_MENU = 1 << 0,
+  UI_REGION_TASKS = 1 << 1,
+  UI_REGION_CLOCK = 1 << 2,
+  UI_REGION_ALL = UI_REGION_MENU | UI_REGION_TASKS | UI_REGION_CLOCK
+} UiRegion;
+
+void ui_invalidate(unsigned int regions);
+
 // --- Drawing and Layout Functions ---
 void ui_draw_layout();
-void ui_display_tasks(WINDOW *win, const Task *tasks, int num_tasks,
-                      const AppConfig *config, int scroll_offset,
-                      int current_selection, AppView current_view);
+void ui_display_tasks(WINDOW *win, const TaskList *list,
+                      const TaskMarks *marks, const AppConfig *config,
+                      int scroll_offset, int current_selection,
+                      AppView current_view);
 void ui_display_menu(WINDOW *win, const AppConfig *config,
                      AppView current_view);
 void ui_display_clock(WINDOW *win, const char *time_string);
 void ui_show_message(const char *translation_key, bool is_error,
                      const AppConfig *config);
+void ui_clear_message();
+void ui_display_search_prompt(const char *query, int match_count,
+                              const AppConfig *config);
+// Shows the performance numbers at the right end of the status line, or
+// removes them if `stats` is NULL.
+void ui_display_perf_overlay(const PerfStats *stats, const AppConfig *config);
+const char *ui_view_name_key(TaskViewKind kind);
 
 // --- Interaction Functions ---
 void ui_display_full_task(const Task *task, const AppConfig *config);
@@ -1,14 +1,29 @@
 #include "undo_manager.h"
-#include "app.h" // For database access
+#include "app.h" // For the writer and the task list
 #include "error.h"
 #include "utils.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+// Frees the descriptions and the task arrays of a command
+static void free_command(Command *cmd) {
+  free(cmd->old_data);
+  free(cmd->new_data);
+  cmd->old_data = NULL;
+  cmd->new_data = NULL;
+  free(cmd->batch_ids);
+  free(cmd->batch_states);
+  cmd->batch_ids = NULL;
+  cmd->batch_states = NULL;
+  cmd->batch_count = 0;
+}
+
 // Internal helper function to push a command onto a stack
 static void push_command(Command *stack, int *top, const Command *cmd) {
   if (*top >= UNDO_STACK_SIZE - 1) {
     // If the stack is full, discard the oldest item
+    free_command(&stack[0]);
     safe_memmove(&stack[0], &stack[1], (UNDO_STACK_SIZE - 1) * sizeof(Command));
     *top = UNDO_STACK_SIZE - 2;
   }
@@ -21,33 +36,118 @@ void undo_manager_init(UndoManager *manager) {
   manager->redo_top = -1;
 }
 
+void undo_manager_destroy(UndoManager *manager) {
+  for (int i = 0; i <= manager->undo_top; i++) {
+    free_command(&manager->undo_stack[i]);
+  }
+  undo_manager_clear_redo(manager);
+  manager->undo_top = -1;
+}
+
 void undo_manager_push(UndoManager *manager, ActionType type, int task_id,
                        const char *old_data, const char *new_data,
-                       int old_state) {
-  Command cmd;
+                       int old_state, unsigned long seq) {
+  Command cmd = {0};
   cmd.type = type;
   cmd.task_id = task_id;
   cmd.old_state = old_state;
+  cmd.seq = seq;
 
   if (old_data) {
-    safe_snprintf(cmd.old_data, MAX_DESCRICAO, "%s", old_data);
-  } else {
-    cmd.old_data[0] = '\0';
+    cmd.old_data = strdup(old_data);
   }
-
   if (new_data) {
-    safe_snprintf(cmd.new_data, MAX_DESCRICAO, "%s", new_data);
+    cmd.new_data = strdup(new_data);
+  }
+
+  push_command(manager->undo_stack, &manager->undo_top, &cmd);
+}
+
+void undo_manager_push_batch(UndoManager *manager, ActionType type,
+                             const int *task_ids, const int *old_states,
+                             int count, unsigned long seq) {
+  Command cmd = {0};
+  cmd.type = type;
+  cmd.task_id = -1;
+  cmd.seq = seq;
+  cmd.batch_ids = malloc(sizeof(int) * (size_t)count);
+  cmd.batch_states = malloc(sizeof(int) * (size_t)count);
+  if (!cmd.batch_ids || !cmd.batch_states) {
+    free_command(&cmd);
+    return;
+  }
+  safe_memcpy(cmd.batch_ids, task_ids, sizeof(int) * (size_t)count);
+  if (old_states) {
+    safe_memcpy(cmd.batch_states, old_states, sizeof(int) * (size_t)count);
   } else {
-    cmd.new_data[0] = '\0';
+    memset(cmd.batch_states, 0, sizeof(int) * (size_t)count);
   }
+  cmd.batch_count = count;
 
   push_command(manager->undo_stack, &manager->undo_top, &cmd);
 }
 
 void undo_manager_clear_redo(UndoManager *manager) {
+  for (int i = 0; i <= manager->redo_top; i++) {
+    free_command(&manager->redo_stack[i]);
+  }
   manager->redo_top = -1;
 }
 
+// Removes the commands tagged with `seq` from a stack
+static void drop_from_stack(Command *stack, int *top, unsigned long seq) {
+  int kept = 0;
+  for (int i = 0; i <= *top; i++) {
+    if (stack[i].seq == seq) {
+      free_command(&stack[i]);
+    } else {
+      stack[kept++] = stack[i];
+    }
+  }
+  *top = kept - 1;
+}
+
+void undo_manager_drop(UndoManager *manager, unsigned long seq) {
+  drop_from_stack(manager->undo_stack, &manager->undo_top, seq);
+  drop_from_stack(manager->redo_stack, &manager->redo_top, seq);
+}
+
+static void remap_in_stack(Command *stack, int top, int old_id, int new_id) {
+  for (int i = 0; i <= top; i++) {
+    if (stack[i].task_id == old_id) {
+      stack[i].task_id = new_id;
+    }
+    for (int j = 0; j < stack[i].batch_count; j++) {
+      if (stack[i].batch_ids[j] == old_id) {
+        stack[i].batch_ids[j] = new_id;
+      }
+    }
+  }
+}
+
+void undo_manager_remap_id(UndoManager *manager, int old_id, int new_id) {
+  remap_in_stack(manager->undo_stack, manager->undo_top, old_id, new_id);
+  remap_in_stack(manager->redo_stack, manager->redo_top, old_id, new_id);
+}
+
+// Toggles the tasks of a multi-task command. With `flip` every task goes back
+// to its saved state (undo), otherwise it leaves it again (redo).
+static OrdoResult toggle_batch(AppState *app, const Command *cmd, bool flip,
+                               unsigned long *seq) {
+  int *current = malloc(sizeof(int) * (size_t)cmd->batch_count);
+  if (!current) {
+    return ORDO_ERROR_GENERIC;
+  }
+  for (int i = 0; i < cmd->batch_count; i++) {
+    current[i] = flip ? !cmd->batch_states[i] : cmd->batch_states[i];
+  }
+  OrdoResult result =
+      writer_toggle_tasks_status(&app->writer, cmd->batch_ids, current,
+                                 cmd->batch_count, &app->task_list, seq);
+  free(current);
+  return result;
+}
+
 bool undo_manager_perform_undo(UndoManager *manager, AppState *app) {
   if (manager->undo_top < 0) {
     return false;
@@ -58,17 +158,30 @@ bool undo_manager_perform_undo(UndoManager *manager, AppState *app) {
 
   switch (cmd.type) {
   case ACTION_ADD:
-    result = database_remove_task(&app->db, cmd.task_id);
+    result = writer_remove_tasks(&app->writer, &cmd.task_id, 1,
+                                 &app->task_list, &cmd.seq);
     break;
   case ACTION_DELETE:
-    result = database_restore_task(&app->db, cmd.task_id);
+    result = writer_restore_tasks(&app->writer, &cmd.task_id, 1,
+                                  &app->task_list, &cmd.seq);
     break;
   case ACTION_EDIT:
-    result =
-        database_update_task_description(&app->db, cmd.task_id, cmd.old_data);
+    result = writer_update_task_description(&app->writer, cmd.task_id,
+                                            cmd.old_data, &app->task_list,
+                                            &cmd.seq);
     break;
-  case ACTION_TOGGLE:
-    result = database_toggle_task_status(&app->db, cmd.task_id, !cmd.old_state);
+  case ACTION_TOGGLE: {
+    int current = !cmd.old_state;
+    result = writer_toggle_tasks_status(&app->writer, &cmd.task_id, &current,
+                                        1, &app->task_list, &cmd.seq);
+    break;
+  }
+  case ACTION_DELETE_MANY:
+    result = writer_restore_tasks(&app->writer, cmd.batch_ids,
+                                  cmd.batch_count, &app->task_list, &cmd.seq);
+    break;
+  case ACTION_TOGGLE_MANY:
+    result = toggle_batch(app, &cmd, true, &cmd.seq);
     break;
   }
 
@@ -92,17 +205,30 @@ bool undo_manager_perform_redo(UndoManager *manager, AppState *app) {
 
   switch (cmd.type) {
   case ACTION_ADD:
-    result = database_restore_task(&app->db, cmd.task_id);
+    result = writer_restore_tasks(&app->writer, &cmd.task_id, 1,
+                                  &app->task_list, &cmd.seq);
     break;
   case ACTION_DELETE:
-    result = database_remove_task(&app->db, cmd.task_id);
+    result = writer_remove_tasks(&app->writer, &cmd.task_id, 1,
+                                 &app->task_list, &cmd.seq);
     break;
   case ACTION_EDIT:
-    result =
-        database_update_task_description(&app->db, cmd.task_id, cmd.new_data);
+    result = writer_update_task_description(&app->writer, cmd.task_id,
+                                            cmd.new_data, &app->task_list,
+                                            &cmd.seq);
+    break;
+  case ACTION_TOGGLE: {
+    int current = cmd.old_state;
+    result = writer_toggle_tasks_status(&app->writer, &cmd.task_id, &current,
+                                        1, &app->task_list, &cmd.seq);
+    break;
+  }
+  case ACTION_DELETE_MANY:
+    result = writer_remove_tasks(&app->writer, cmd.batch_ids, cmd.batch_count,
+                                 &app->task_list, &cmd.seq);
     break;
-  case ACTION_TOGGLE:
-    result = database_toggle_task_status(&app->db, cmd.task_id, cmd.old_state);
+  case ACTION_TOGGLE_MANY:
+    result = toggle_batch(app, &cmd, false, &cmd.seq);
     break;
   }
 
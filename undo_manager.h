@@ -12,16 +12,24 @@ typedef enum {
   ACTION_ADD,
   ACTION_DELETE,
   ACTION_EDIT,
-  ACTION_TOGGLE
+  ACTION_TOGGLE,
+  ACTION_DELETE_MANY,
+  ACTION_TOGGLE_MANY
 } ActionType;
 
 // Structure that stores a single action for the history
 typedef struct {
   ActionType type;
   int task_id;
-  char old_data[MAX_DESCRICAO];
-  char new_data[MAX_DESCRICAO];
+  char *old_data; // Descriptions before and after the action (owned)
+  char *new_data;
   int old_state;
+  // Multi-task actions: the IDs and their previous states (owned)
+  int *batch_ids;
+  int *batch_states;
+  int batch_count;
+  // Sequence number of the write that last applied this action
+  unsigned long seq;
 } Command;
 
 #define UNDO_STACK_SIZE 10
@@ -36,10 +44,18 @@ typedef struct {
 
 // --- Public Functions ---
 void undo_manager_init(UndoManager *manager);
+void undo_manager_destroy(UndoManager *manager);
 void undo_manager_push(UndoManager *manager, ActionType type, int task_id,
                        const char *old_data, const char *new_data,
-                       int old_state);
+                       int old_state, unsigned long seq);
+void undo_manager_push_batch(UndoManager *manager, ActionType type,
+                             const int *task_ids, const int *old_states,
+                             int count, unsigned long seq);
 void undo_manager_clear_redo(UndoManager *manager);
+// Forgets the actions whose last write (sequence number `seq`) failed
+void undo_manager_drop(UndoManager *manager, unsigned long seq);
+// Replaces a provisional task ID once the database has assigned the real one
+void undo_manager_remap_id(UndoManager *manager, int old_id, int new_id);
 bool undo_manager_perform_undo(UndoManager *manager, struct AppState *app);
 bool undo_manager_perform_redo(UndoManager *manager, struct AppState *app);
 
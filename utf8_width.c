@@ -0,0 +1,646 @@
+#include "utf8_width.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define ZWJ 0x200d
+#define ONES ((uint64_t)0x0101010101010101)
+#define HIGH_BITS (ONES * 0x80)
+
+// Generated from the Unicode 14.0 data: general categories Mn, Me and Cf
+// take no column, East Asian Width W and F take two. Like glibc, the soft
+// hyphen and the prepended concatenation marks take one, Hangul medial vowels
+// and final consonants take none, and the unassigned code points of planes 2
+// and 3 take two. Past plane 3, only the tags and variation selectors of
+// plane 14 take no column, which utf8_codepoint_width tests directly.
+
+// The page of each 256 code points of planes 0 to 3
+static const uint8_t width_page_index[0x400] = {
+    0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+    14, 15, 0, 16, 0, 0, 0, 17, 18, 19, 20, 21, 22, 23, 0, 0,
+    24, 0, 0, 25, 0, 26, 27, 28, 0, 0, 0, 29, 30, 31, 32, 33,
+    34, 35, 36, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 38, 0, 39, 0, 40, 41, 42, 43, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 44, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 37, 45, 46, 0, 0, 47, 48,
+    0, 49, 50, 51, 0, 0, 0, 0, 0, 0, 52, 0, 0, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 0, 67, 68, 69, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 70, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 71, 72, 0, 0, 0, 73,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 74, 37, 37, 37, 37, 75, 76, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 77,
+    37, 78, 79, 0, 0, 0, 0, 0, 0, 0, 0, 0, 80, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 81,
+    0, 82, 83, 0, 0, 0, 0, 0, 0, 0, 84, 0, 0, 0, 0, 0,
+    85, 72, 86, 0, 0, 0, 0, 0, 87, 88, 0, 0, 0, 0, 0, 0,
+    89, 90, 91, 92, 93, 94, 95, 96, 0, 97, 98, 0, 0, 0, 0, 0,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 99,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37,
+    37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 37, 99,
+};
+
+// Two bits per code point, from the lowest: 0 for one column, 1 for none,
+// 2 for two
+static const uint16_t width_pages[100][32] = {
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555,
+     0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x5540, 0x0005, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5554, 0x5555, 0x5555, 0x5555, 0x5555, 0x4555,
+     0x4514, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x5555, 0x0115, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x5540, 0x5555, 0x5555, 0x0000, 0x0000, 0x0001, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5000, 0x4155, 0x4155, 0x0551, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0004, 0x0000, 0x0000, 0x0000, 0x5555, 0x5555,
+     0x5555, 0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x5000, 0x5555, 0x0001, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5540, 0x0055, 0x0400},
+    {0x0000, 0x0000, 0x5000, 0x5545, 0x5455, 0x0554, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0054, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x5555, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x5550, 0x5555, 0x5555, 0x5545, 0x5555, 0x5555, 0x5555},
+    {0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0110,
+     0x5554, 0x0401, 0x5554, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000,
+     0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0100,
+     0x0154, 0x0400, 0x0000, 0x0000, 0x0050, 0x0000, 0x0000, 0x1000},
+    {0x0014, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0100,
+     0x4014, 0x0541, 0x0004, 0x0000, 0x0000, 0x0000, 0x0405, 0x0000,
+     0x0014, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0100,
+     0x4554, 0x0401, 0x0000, 0x0000, 0x0050, 0x0000, 0x0000, 0x5550},
+    {0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4100,
+     0x0154, 0x0400, 0x1400, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000,
+     0x0010, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0001, 0x0400, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0101, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5100,
+     0x5001, 0x0551, 0x1400, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000,
+     0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4100,
+     0x1000, 0x0500, 0x0000, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000},
+    {0x0005, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0140,
+     0x0154, 0x0400, 0x0000, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000,
+     0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0010, 0x1150, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5504, 0x0015,
+     0x4000, 0x1555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5504, 0x0155,
+     0x0000, 0x0555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0005, 0x0000, 0x0000, 0x4400, 0x0004,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5554, 0x1555,
+     0x5155, 0x5400, 0x5555, 0x5554, 0x5555, 0x5555, 0x5555, 0x0155,
+     0x1000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5400, 0x5551, 0x1414,
+     0x0000, 0x0000, 0x0000, 0x5005, 0x0001, 0x0000, 0x0154, 0x0000,
+     0x1410, 0x0400, 0x0000, 0x0400, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x5555, 0x5555, 0x5555, 0x5555,
+     0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555,
+     0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x5400, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0150, 0x0000, 0x0000, 0x0000, 0x0050, 0x0000,
+     0x0000, 0x0000, 0x0050, 0x0000, 0x0000, 0x0000, 0x0050, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4500, 0x0555,
+     0x1000, 0x5554, 0x0055, 0x0400, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x5540, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x1400, 0x0000, 0x0000, 0x0000, 0x0000, 0x0004, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x4015, 0x0001, 0x0010, 0x0054,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x4000, 0x0041, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x1000, 0x1555, 0x5411, 0x0155, 0x5540, 0x4155,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5555, 0x5555,
+     0x5555, 0x1555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0055, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5100, 0x0115,
+     0x0010, 0x0000, 0x0000, 0x0000, 0x0000, 0x5540, 0x0055, 0x0000,
+     0x0005, 0x0000, 0x0000, 0x0000, 0x0550, 0x0545, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x1000, 0x4405, 0x0005, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5500, 0x5055, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5515, 0x5555, 0x5551, 0x0401, 0x0100, 0x0005},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555},
+    {0x0000, 0x5540, 0x0000, 0x0000, 0x0000, 0x1550, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x5155, 0x5555, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5555, 0x5555, 0x5555, 0x5555, 0x0001, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x00a0, 0x0000, 0x0028, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x02a8, 0x0082, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x2800},
+    {0x0000, 0x0000, 0x0a00, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0xaaaa, 0x00aa, 0x0000, 0x0000, 0x0000, 0x0000, 0x8000,
+     0x0000, 0x0000, 0x0080, 0x0000, 0x0008, 0x00a0, 0x0000, 0x2800,
+     0x0a00, 0x2000, 0x0200, 0x0000, 0x0000, 0x0020, 0x08a0, 0x0820},
+    {0x0800, 0x00a0, 0x0000, 0x0000, 0x0000, 0x0002, 0x0000, 0x0000,
+     0x0000, 0x2200, 0x8a80, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0xa800, 0x0000, 0x0000, 0x0000, 0x0002, 0x8000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0280, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0802, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x0005, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x5555, 0x5555, 0x5555, 0x5555},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaa8a, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x00aa, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0x0aaa, 0x0000, 0x0000, 0x0000, 0xaaaa, 0x00aa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xa55a, 0xaaaa, 0x2aaa,
+     0xaaa8, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0x2aaa, 0xaa94, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa},
+    {0xa800, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaa8, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0x2aaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x00aa, 0x0000, 0xaaaa, 0xaaaa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0x2aaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0x02aa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0x2aaa, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x5515, 0x0555,
+     0x0000, 0x0000, 0x0000, 0x5000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0005, 0x0000},
+    {0x1010, 0x0040, 0x0000, 0x0000, 0x1400, 0x0100, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0500, 0x0000, 0x0000, 0x0000, 0x5555, 0x5555, 0x0005, 0x4000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x5000, 0x0555, 0x0000, 0x0000,
+     0x4000, 0x5555, 0x0005, 0x0000, 0xaaaa, 0xaaaa, 0xaaaa, 0x02aa,
+     0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5040, 0x0505,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0400, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1554, 0x1414, 0x0000,
+     0x0040, 0x0100, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0100,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4151, 0x5001,
+     0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0500, 0x1000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0400, 0x0401, 0x0000, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x00aa, 0x0000, 0x5555, 0x5555,
+     0x1555, 0x5540, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x0055},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0aaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0x000a, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x1000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x5555, 0x5555, 0xaaaa, 0x000a, 0x5555, 0x5555, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaa2a, 0xaaaa, 0x2aaa, 0x00aa, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000},
+    {0xaaa8, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0002, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x2aaa, 0x0000, 0x0000, 0x0054},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0400},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0001, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5000, 0x0015,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x1454, 0x5500, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4015,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x1400, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x5500, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0140, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x5000, 0x5555, 0x0001, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0550, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0004, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5555,
+     0x1555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0141, 0x4000,
+     0x0005, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1540, 0x0014,
+     0x0010, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0015, 0x0000, 0x0000, 0x0000, 0x4000, 0x5455, 0x0155, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0040, 0x0000,
+     0x0005, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5000, 0x1555,
+     0x0000, 0x4154, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x5105, 0x1000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x4000, 0x5540, 0x0015, 0x0000, 0x0000},
+    {0x0005, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0140,
+     0x0001, 0x0000, 0x0000, 0x0000, 0x5000, 0x0155, 0x0155, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5555,
+     0x1150, 0x0000, 0x0000, 0x1000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5540, 0x4011,
+     0x0051, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0550, 0x4500,
+     0x0001, 0x0000, 0x0000, 0x0500, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5540, 0x4415,
+     0x0001, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0440, 0x4555, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x5400, 0x4550, 0x0055, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x5555, 0x0014,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1140,
+     0x0040, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5500, 0x0050, 0x0001, 0x0000, 0x0000, 0x0000},
+    {0x5554, 0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x5540, 0x1541,
+     0x4000, 0x0000, 0x1554, 0x0054, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x5550, 0x1555, 0x0005, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1555, 0x4555,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x5550, 0x5555, 0x5555, 0x5550, 0x1451, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1554, 0x4510,
+     0x4555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x4405, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0140, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5555, 0x0001,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0155, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1555, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x4000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x4000, 0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x01aa, 0x0000, 0x000a, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0x0aaa, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0xaaaa, 0x0002, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xa8aa, 0x28aa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x002a, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x002a, 0x0000, 0xaa00, 0x0000, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x00aa},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x1400, 0x0055, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x0555, 0x5555, 0x5555,
+     0x1555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x4000, 0x0005, 0x5540, 0x5555,
+     0x5415, 0x0055, 0x0000, 0x0000, 0x0000, 0x0550, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0150, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x1555, 0x5540,
+     0x5555, 0x5555, 0x5555, 0x5555, 0x5555, 0x0155, 0x0400, 0x0000,
+     0x0100, 0x0000, 0x0000, 0x5540, 0x5554, 0x5555, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x1555, 0x5555, 0x5555, 0x5541, 0x5145, 0x0015, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x5500, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x1555, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x5500, 0x0015, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0200, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x8000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x2000, 0xaaa8, 0x002a, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0x002a, 0x0000, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x00aa,
+     0xaaaa, 0x0002, 0x000a, 0x0000, 0x0aaa, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0002, 0xa800, 0x8aaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xa2aa,
+     0xaaaa, 0xaaaa, 0x00aa, 0x0000, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0x802a, 0x00aa, 0x0000, 0xaaaa, 0xaaaa, 0x0202, 0xaaaa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x2aaa,
+     0xaaa2, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x82aa},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0aaa,
+     0x0000, 0x2a80, 0xaaaa, 0xaaaa, 0xaaaa, 0x0000, 0x0000, 0x0020,
+     0x0000, 0x0000, 0x2800, 0x0000, 0x0200, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xaa80},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0x0aaa, 0x0200, 0xa82a, 0xa800, 0x0000, 0x0280, 0xaa00, 0x02aa},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0xaaaa, 0x00aa, 0x0002, 0x0000},
+    {0x0000, 0xaa00, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaa2a,
+     0x8aaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa},
+    {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+     0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x02aa, 0x02aa,
+     0x2aaa, 0x0000, 0xaaaa, 0xaaaa, 0xaaaa, 0x02aa, 0xaaaa, 0x002a,
+     0x0aaa, 0x0000, 0xaaaa, 0x000a, 0xaaaa, 0x0000, 0x2aaa, 0x0000},
+    {0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa,
+     0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0xaaaa, 0x0aaa},
+};
+
+// Whether eight bytes are all printable ASCII, 0x20 to 0x7e, tested a word
+// at a time: the first term flags a byte below 0x20, the second one above
+// 0x7e.
+static bool printable_ascii8(const char *s) {
+  uint64_t word;
+  memcpy(&word, s, sizeof(word));
+  uint64_t below = (word - ONES * 0x20) & ~word & HIGH_BITS;
+  uint64_t above = ((word + ONES) | word) & HIGH_BITS;
+  return (below | above) == 0;
+}
+
+static bool is_regional_indicator(uint32_t cp) {
+  return cp >= 0x1f1e6 && cp <= 0x1f1ff;
+}
+
+static bool is_emoji_modifier(uint32_t cp) {
+  return cp >= 0x1f3fb && cp <= 0x1f3ff;
+}
+
+static inline int codepoint_width(uint32_t cp) {
+  if (cp < 0x7f)
+    return cp >= 0x20 ? 1 : -1;
+  if (cp < 0xa0 || cp == 0x2028 || cp == 0x2029)
+    return -1;
+  if (cp >= 0x40000)
+    return cp == 0xe0001 || (cp >= 0xe0020 && cp <= 0xe007f) ||
+                   (cp >= 0xe0100 && cp <= 0xe01ef)
+               ? 0
+               : 1;
+  static const int8_t widths[4] = {1, 0, 2, 1};
+  uint16_t bits = width_pages[width_page_index[cp >> 8]][(cp & 0xff) >> 3];
+  return widths[(bits >> ((cp & 7) * 2)) & 3];
+}
+
+static inline bool continuation(unsigned char byte) {
+  return (byte & 0xc0) == 0x80;
+}
+
+static inline size_t decode(const unsigned char *s, size_t len, uint32_t *cp) {
+  unsigned char lead = s[0];
+  if (lead < 0x80) {
+    *cp = lead;
+    return 1;
+  }
+  uint32_t value;
+  if (lead < 0xe0) {
+    if (lead >= 0xc2 && len >= 2 && continuation(s[1])) {
+      *cp = ((uint32_t)(lead & 0x1f) << 6) | (s[1] & 0x3f);
+      return 2;
+    }
+  } else if (lead < 0xf0) {
+    if (len >= 3 && continuation(s[1]) && continuation(s[2])) {
+      value = ((uint32_t)(lead & 0x0f) << 12) |
+              ((uint32_t)(s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+      // Not overlong, nor a surrogate
+      if (value >= 0x800 && (value < 0xd800 || value > 0xdfff)) {
+        *cp = value;
+        return 3;
+      }
+    }
+  } else if (lead < 0xf5) {
+    if (len >= 4 && continuation(s[1]) && continuation(s[2]) &&
+        continuation(s[3])) {
+      value = ((uint32_t)(lead & 0x07) << 18) |
+              ((uint32_t)(s[1] & 0x3f) << 12) |
+              ((uint32_t)(s[2] & 0x3f) << 6) | (s[3] & 0x3f);
+      if (value >= 0x10000 && value <= 0x10ffff) {
+        *cp = value;
+        return 4;
+      }
+    }
+  }
+  *cp = 0xfffd;
+  return 1;
+}
+
+int utf8_codepoint_width(uint32_t cp) { return codepoint_width(cp); }
+
+size_t utf8_decode(const char *s, size_t len, uint32_t *cp) {
+  return decode((const unsigned char *)s, len, cp);
+}
+
+size_t utf8_cluster(const char *s, size_t len, int *width) {
+  const unsigned char *bytes = (const unsigned char *)s;
+  uint32_t cp;
+  size_t size = decode(bytes, len, &cp);
+  int cp_width = codepoint_width(cp);
+  if (cp_width < 0) {
+    *width = 1; // Control characters stand alone, shown as a '?'
+    return size;
+  }
+
+  *width = cp_width;
+  bool joined = false; // The last code point was a ZWJ
+  bool regional = is_regional_indicator(cp);
+  while (size < len) {
+    // Nothing joins a plain ASCII character, except after a ZWJ
+    if (!joined && bytes[size] < 0x80)
+      break;
+    uint32_t next;
+    size_t next_size = decode(bytes + size, len - size, &next);
+    int next_width = codepoint_width(next);
+    if (next_width < 0)
+      break;
+    if (!joined && next_width != 0 && !is_emoji_modifier(next) &&
+        !(regional && is_regional_indicator(next)))
+      break;
+    regional = false; // A flag is a single pair
+    joined = next == ZWJ;
+    *width += next_width;
+    size += next_size;
+  }
+  return size;
+}
+
+int utf8_width(const char *s, size_t len) {
+  // A cluster is as wide as its code points together, so the width needs no
+  // cluster boundaries.
+  const unsigned char *bytes = (const unsigned char *)s;
+  int width = 0;
+  size_t i = 0;
+  while (i < len) {
+    if (len - i >= 8 && printable_ascii8(s + i)) {
+      width += 8;
+      i += 8;
+      continue;
+    }
+    uint32_t cp;
+    i += decode(bytes + i, len - i, &cp);
+    int cp_width = codepoint_width(cp);
+    width += cp_width < 0 ? 1 : cp_width;
+  }
+  return width;
+}
+
+size_t utf8_prefix(const char *s, size_t len, int max_width, int *width) {
+  int total = 0;
+  size_t i = 0;
+  while (i < len) {
+    // A run is only taken whole when no mark or modifier after it could
+    // join its last character.
+    if (len - i >= 8 && total + 8 <= max_width && printable_ascii8(s + i) &&
+        (len - i == 8 || (unsigned char)s[i + 8] < 0x80)) {
+      total += 8;
+      i += 8;
+      continue;
+    }
+    int cluster_width;
+    size_t size = utf8_cluster(s + i, len - i, &cluster_width);
+    if (total + cluster_width > max_width)
+      break;
+    total += cluster_width;
+    i += size;
+  }
+  if (width)
+    *width = total;
+  return i;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file utf8_width.h
+ * @brief Display width and cutting of UTF-8 text, without conversions or
+ * allocations.
+ *
+ * Works on the UTF-8 bytes directly: no `mbstowcs` into a wide buffer and no
+ * locale. Runs of printable ASCII, most of what a task list holds, are
+ * measured eight bytes at a time. Other code points are looked up in a
+ * two-stage table generated from Unicode 14.0, with the same exceptions as
+ * glibc's `wcwidth`, so that widths agree with where ncurses puts the cells.
+ *
+ * Text is measured and cut by grapheme cluster: a base character with its
+ * combining marks, variation selectors, emoji modifiers and ZWJ sequences,
+ * or a pair of regional indicators. A cut never separates them. The width of
+ * a cluster is the sum of its code points' widths, which is what ncurses
+ * occupies for it.
+ */
+
+#ifndef UTF8_WIDTH_H
+#define UTF8_WIDTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Returns the columns a code point takes on its own.
+ * @param[in] cp The code point.
+ * @return 0 for combining and format characters, 2 for wide ones, 1 for the
+ * rest, or -1 for control characters.
+ */
+int utf8_codepoint_width(uint32_t cp);
+
+/**
+ * @brief Decodes the UTF-8 sequence at the start of a string.
+ * @param[in] s The string.
+ * @param[in] len The bytes of `s` available, at least 1.
+ * @param[out] cp Receives the code point, or U+FFFD if the sequence is
+ * invalid or cut short.
+ * @return The bytes the sequence takes; 1 for an invalid byte.
+ */
+size_t utf8_decode(const char *s, size_t len, uint32_t *cp);
+
+/**
+ * @brief Finds the grapheme cluster at the start of a string.
+ * @param[in] s The string.
+ * @param[in] len The bytes of `s` available, at least 1.
+ * @param[out] width Receives the columns of the cluster. Control characters
+ * and invalid bytes count as one column each, for the '?' they are shown as.
+ * @return The bytes the cluster takes.
+ */
+size_t utf8_cluster(const char *s, size_t len, int *width);
+
+/**
+ * @brief Returns the display width of a UTF-8 string.
+ * @param[in] s The string.
+ * @param[in] len Its length in bytes.
+ */
+int utf8_width(const char *s, size_t len);
+
+/**
+ * @brief Finds the longest prefix of a UTF-8 string that fits in a width,
+ * made of whole grapheme clusters.
+ * @param[in] s The string.
+ * @param[in] len Its length in bytes.
+ * @param[in] max_width The columns available.
+ * @param[out] width Receives the width of the prefix; may be NULL.
+ * @return The length of the prefix in bytes.
+ */
+size_t utf8_prefix(const char *s, size_t len, int max_width, int *width);
+
+#endif // UTF8_WIDTH_H
@@ -4,7 +4,9 @@
 
 #include "utils.h"
 #include "database.h"
+#include "perf_stats.h"
 #include "platform_utils.h"
+#include "utf8_width.h"
 #include <ctype.h>
 #include <errno.h>
 #include <stdarg.h>
@@ -31,46 +33,39 @@ char *trim(const char *str) {
   if (!str)
     return NULL;
 
-  size_t len = strlen(str);
-  wchar_t *w_str = malloc((len + 1) * sizeof(wchar_t));
-  if (!w_str)
-    return NULL;
-  mbstowcs(w_str, str, len + 1);
-
-  const wchar_t *start = w_str;
-  while (*start && iswspace(*start)) {
-    start++;
-  }
-
-  const wchar_t *end = w_str + wcslen(w_str) - 1;
-  while (end > start && iswspace(*end)) {
-    end--;
-  }
-
-  size_t new_len = (end - start) + 1;
-  wchar_t *w_trimmed = malloc((new_len + 1) * sizeof(wchar_t));
-  if (!w_trimmed) {
-    free(w_str);
-    return NULL;
+  // Decode the string in place, remembering where the first character and
+  // the end of the last character that are not whitespace lie.
+  mbstate_t state = {0};
+  const char *p = str;
+  const char *start = NULL;
+  const char *end = str;
+  size_t remaining = strlen(str);
+  while (remaining > 0) {
+    wchar_t wc;
+    size_t n = mbrtowc(&wc, p, remaining, &state);
+    if (n == (size_t)-1 || n == (size_t)-2) {
+      // Invalid sequence: keep the byte as a non-space character
+      n = 1;
+      wc = L'?';
+      memset(&state, 0, sizeof(state));
+    }
+    if (!iswspace(wc)) {
+      if (!start)
+        start = p;
+      end = p + n;
+    }
+    p += n;
+    remaining -= n;
   }
+  if (!start)
+    start = end;
 
-  wcsncpy(w_trimmed, start, new_len);
-  w_trimmed[new_len] = L'\0';
-
-  size_t mb_len = wcstombs(NULL, w_trimmed, 0);
-  char *trimmed_str = malloc(mb_len + 1);
-  
-  if (!trimmed_str) {
-    free(w_str);
-    free(w_trimmed);
+  size_t new_len = (size_t)(end - start);
+  char *trimmed_str = ordo_malloc(new_len + 1);
+  if (!trimmed_str)
     return NULL; // Return in case of allocation failure
-  }
-
-  wcstombs(trimmed_str, w_trimmed, mb_len + 1);
-
-  free(w_str);
-  free(w_trimmed);
-
+  memcpy(trimmed_str, start, new_len);
+  trimmed_str[new_len] = '\0';
   return trimmed_str;
 }
 
@@ -78,56 +73,101 @@ void truncate_by_width(char *dest, size_t dest_size, const char *src,
                          int max_width) {
   if (dest_size == 0)
     return;
-  dest[0] = '\0';
-
-  const wchar_t *ellipsis = L"...";
-  size_t src_len = strlen(src);
-
-  // Allocates space for the string + ellipsis + null terminator
-  wchar_t *w_src = malloc((src_len + wcslen(ellipsis) + 1) * sizeof(wchar_t));
-  if (!w_src) {
-    return;
-  } // Allocation failure
-  mbstowcs(w_src, src, src_len + 1);
-
-  int total_width = wcswidth(w_src, -1);
-
-  // If the string already fits, just copy it
-  if (total_width <= max_width) {
-    safe_snprintf(dest, dest_size, "%s", src);
-    free(w_src);
+  const int ellipsis_width = 3;
+  int target_width = max_width > ellipsis_width ? max_width - ellipsis_width : 0;
+  size_t len = strlen(src);
+  size_t room = dest_size - 1;
+
+  // The prefix the ellipsis would follow, cut at a cluster boundary and
+  // never inside a sequence
+  size_t limit = room > 3 ? room - 3 : 0;
+  if (limit < len) {
+    while (limit > 0 && ((unsigned char)src[limit] & 0xc0) == 0x80)
+      limit--;
+  } else {
+    limit = len;
+  }
+  int cut_width;
+  size_t cut = utf8_prefix(src, limit, target_width, &cut_width);
+
+  // If the string already fits, just copy it; the measure goes on from the
+  // prefix, so the string is read once.
+  if (len <= room &&
+      cut + utf8_prefix(src + cut, len - cut, max_width - cut_width, NULL) ==
+          len) {
+    memcpy(dest, src, len + 1);
     return;
   }
 
-  // Truncates and adds ellipsis
-  int ellipsis_width = wcswidth(ellipsis, -1);
-  int target_width = max_width - ellipsis_width;
-  if (target_width < 0)
-    target_width = 0;
+  // Truncates and adds the ellipsis
+  size_t dots = room - cut < 3 ? room - cut : 3;
+  memcpy(dest, src, cut);
+  memset(dest + cut, '.', dots);
+  dest[cut + dots] = '\0';
+}
 
-  int current_width = 0;
-  size_t end_index = 0;
-  while (w_src[end_index] != L'\0') {
-    int char_width = wcwidth(w_src[end_index]);
-    if (char_width < 0)
-      char_width = 1;
+int str_width(const char *str) { return utf8_width(str, strlen(str)); }
+
+// Stores a code point as one wide character, or as a surrogate pair where
+// wchar_t has 16 bits. Returns the characters stored.
+static size_t put_wide(wchar_t *dest, uint32_t cp) {
+#if WCHAR_MAX <= 0xffff
+  if (cp > 0xffff) {
+    cp -= 0x10000;
+    dest[0] = (wchar_t)(0xd800 + (cp >> 10));
+    dest[1] = (wchar_t)(0xdc00 + (cp & 0x3ff));
+    return 2;
+  }
+#endif
+  dest[0] = (wchar_t)cp;
+  return 1;
+}
 
-    if (current_width + char_width > target_width) {
+int wide_truncate_by_width(wchar_t *dest, size_t dest_len, const char *src,
+                           int max_width) {
+  const int ellipsis_width = 3;
+  int target_width = max_width > ellipsis_width ? max_width - ellipsis_width : 0;
+  size_t src_len = strlen(src);
+  size_t count = 0, fit_count = 0; // fit_count: the prefix the ellipsis follows
+  int width = 0, fit_width = 0;
+  bool truncated = false;
+
+  // A single pass measures, cuts and converts, a grapheme cluster at a time.
+  for (size_t i = 0; i < src_len;) {
+    int cluster_width;
+    size_t size;
+    unsigned char byte = (unsigned char)src[i];
+    if (byte >= 0x20 && byte < 0x7f && (unsigned char)src[i + 1] < 0x80) {
+      cluster_width = size = 1; // Printable ASCII that nothing joins
+    } else {
+      size = utf8_cluster(src + i, src_len - i, &cluster_width);
+    }
+    if (width + cluster_width > max_width || count + size + 4 > dest_len) {
+      truncated = true;
       break;
     }
-    current_width += char_width;
-    end_index++;
+    for (size_t end = i + size; i < end;) {
+      uint32_t cp;
+      i += utf8_decode(src + i, end - i, &cp);
+      if (cp == 0xfffd || utf8_codepoint_width(cp) < 0)
+        cp = '?';
+      count += put_wide(dest + count, cp);
+    }
+    width += cluster_width;
+    if (width <= target_width) {
+      fit_count = count;
+      fit_width = width;
+    }
   }
 
-  // Builds the final truncated string with ellipsis
-  w_src[end_index] = L'\0'; // Truncates the wide string
-  wcscat(w_src, ellipsis);  // Adds the ellipsis
-
-  // Converts back to multibyte (UTF-8) and copies to the destination
-  wcstombs(dest, w_src, dest_size);
-  dest[dest_size - 1] = '\0';
-
-  free(w_src);
+  if (truncated) {
+    count = fit_count;
+    width = fit_width;
+    for (int i = 0; i < ellipsis_width && width < max_width; i++, width++)
+      dest[count++] = L'.';
+  }
+  dest[count] = L'\0';
+  return width;
 }
 
 int get_database_path(char *buffer, size_t buffer_size) {
@@ -167,98 +207,102 @@ int get_database_path(char *buffer, size_t buffer_size) {
   return 0;
 }
 
-char *word_wrap(const char *src, int max_width) {
+int wrap_text(const char *src, int max_width, TextSpan **spans_out) {
+  *spans_out = NULL;
   if (!src)
-    return NULL;
-
-  size_t src_len = strlen(src);
-  wchar_t *w_src = malloc((src_len + 1) * sizeof(wchar_t));
-  if (!w_src)
-    return NULL;
-  mbstowcs(w_src, src, src_len + 1);
-
-  // Allocates a result buffer that is certainly large enough
-  wchar_t *w_dest = malloc((wcslen(w_src) * 2 + 1) * sizeof(wchar_t));
-  if (!w_dest) {
-    free(w_src);
-    return NULL;
-  }
-  w_dest[0] = L'\0';
-
-  wchar_t *p = w_src;
-  wchar_t *line_start = p;
-  int current_width = 0;
-
-  while (*p) {
-    // Finds the end of the next word or the end of the string
-    wchar_t *word_end = p;
-    int word_width = 0;
-    while (*word_end && !iswspace(*word_end)) {
-      word_width += wcwidth(*word_end);
-      word_end++;
+    return 0;
+  if (max_width < 1)
+    max_width = 1;
+
+  TextSpan *spans = NULL;
+  int count = 0, capacity = 0;
+  int src_len = (int)strlen(src);
+  int line_start = 0;   // Where the current line starts
+  int line_width = 0;   // Its width so far, spaces included
+  int space_start = -1; // Where the last run of spaces on the line starts
+  int word_start = 0;   // Where the word after that run starts
+  int word_width = 0;   // The width of that word so far
+  bool in_space = true; // Leading spaces are dropped like those at a break
+  int i = 0;
+  for (;;) {
+    // A grapheme cluster at a time, known by its first code point
+    uint32_t ch = 0;
+    int len = 0;
+    int cluster_width = 0;
+    if (i < src_len) {
+      utf8_decode(src + i, (size_t)(src_len - i), &ch);
+      len = (int)utf8_cluster(src + i, (size_t)(src_len - i), &cluster_width);
     }
 
-    // If the word itself is larger than the line width, break it
-    if (word_width > max_width) {
-      if (current_width > 0) {
-        wcscat(w_dest, L"\n");
-        current_width = 0;
+    bool hard_break = ch == 0 || ch == '\n';
+    bool soft_break = false;
+    int width = 0;
+    if (!hard_break && !iswspace((wint_t)ch)) {
+      if (in_space) {
+        word_start = i;
+        word_width = 0;
+        in_space = false;
+      }
+      width = cluster_width;
+      soft_break = line_width + width > max_width && line_width > 0;
+    }
+    // A line ends at a newline or at the end, without its trailing spaces,
+    // and before a character that does not fit: at the last space if there
+    // is one, or else inside the word.
+    if (hard_break || soft_break) {
+      int end = i;
+      int next = i;
+      if (hard_break) {
+        if (in_space && space_start >= line_start)
+          end = space_start;
+        next = i + len;
+      } else if (space_start > line_start) {
+        // Breaks at the last space; the word typed so far moves down
+        end = space_start;
+        next = word_start;
       }
-      wchar_t *char_p = p;
-      while (char_p < word_end) {
-        int char_width = wcwidth(*char_p);
-        if (current_width + char_width > max_width) {
-          wcscat(w_dest, L"\n");
-          current_width = 0;
+      if (end > line_start || ch == '\n') {
+        if (count == capacity) {
+          capacity = capacity ? capacity * 2 : 16;
+          TextSpan *grown =
+              ordo_realloc(spans, sizeof(TextSpan) * (size_t)capacity);
+          if (!grown) {
+            free(spans);
+            return -1;
+          }
+          spans = grown;
         }
-        wcsncat(w_dest, char_p, 1);
-        current_width += char_width;
-        char_p++;
+        spans[count++] = (TextSpan){line_start, end - line_start};
       }
-      p = word_end;
-      current_width = 0; // The next word starts on a new line
-      line_start = p;
-      // Adds space if there is any
-      while (*p && iswspace(*p)) {
-        p++;
+      if (ch == 0)
+        break;
+      line_start = next;
+      line_width = hard_break || next == i ? 0 : word_width;
+      space_start = -1;
+      if (hard_break) {
+        in_space = true;
+        i = next;
+        continue;
       }
-      continue;
-    }
-
-    // Checks if the word fits on the current line
-    if (current_width + (p == line_start ? 0 : 1) + word_width > max_width) {
-      wcscat(w_dest, L"\n");
-      current_width = 0;
-      line_start = p;
-    }
-
-    // Adds the word to the result
-    if (current_width > 0) {
-      wcscat(w_dest, L" ");
-      current_width++;
     }
 
-    wcsncat(w_dest, p, word_end - p);
-    current_width += word_width;
-    p = word_end;
-
-    // Skips the whitespace
-    while (*p && iswspace(*p)) {
-      p++;
+    if (iswspace((wint_t)ch)) {
+      if (!in_space) {
+        space_start = i;
+        in_space = true;
+      }
+      if (line_width == 0 && space_start < line_start)
+        line_start = i + len; // Dropped at the start of a line
+      else
+        line_width++;
+    } else {
+      line_width += width;
+      word_width += width;
     }
+    i += len;
   }
-
-  free(w_src);
-
-  // Converts the resulting wide string back to multibyte
-  size_t dest_len = wcstombs(NULL, w_dest, 0);
-  char *dest = malloc(dest_len + 1);
-  if (dest) {
-    wcstombs(dest, w_dest, dest_len + 1);
-  }
-
-  free(w_dest);
-  return dest;
+  *spans_out = spans;
+  return count;
 }
 
 char *path_join(const char *base, const char *leaf) {
@@ -281,7 +325,7 @@ char *path_join(const char *base, const char *leaf) {
 
     // Calculates the total size and allocates memory
     size_t total_len = base_len + 1 + leaf_len + 1; // +1 for the slash, +1 for the null
-    char *result = malloc(total_len);
+    char *result = ordo_malloc(total_len);
     if (!result) return NULL;
 
     // Builds the final path
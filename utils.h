@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <wchar.h>
 
 // --- Automatic Memory Management (Smart Pointer Style) ---
 // GCC/Clang attribute to call a cleanup function when the variable goes out of scope.
@@ -26,11 +27,29 @@ void truncate_by_width(char *dest, size_t dest_size, const char *src,
 			 int max_width);
 int get_database_path(char *buffer, size_t buffer_size);
 char *trim(const char *str);
-char *word_wrap(const char *src, int max_width);
 char *path_join(const char *base, const char *leaf);
 void generate_line(char *buffer, size_t buffer_size, const char *ch,
                    int length);
 int str_width(const char *str);
+// Converts src into dest, a wide string cut to max_width columns and ended
+// with "..." if it did not fit. Bytes that do not decode and characters with
+// no width are shown as '?'. dest must hold strlen(src) + 4 characters.
+// Returns the width of the result.
+int wide_truncate_by_width(wchar_t *dest, size_t dest_len, const char *src,
+                           int max_width);
+
+// A line of wrapped text: `len` bytes of the source from byte `start`.
+typedef struct {
+  int start;
+  int len;
+} TextSpan;
+
+// Wraps src into lines of at most max_width columns in a single pass,
+// breaking at spaces, inside words longer than a line and at every newline.
+// The spaces a line breaks at are left out of both lines. Stores a
+// malloc'd array of the lines in *spans_out (NULL if there are none).
+// Returns the number of lines, or -1 if memory ran out.
+int wrap_text(const char *src, int max_width, TextSpan **spans_out);
 
 // --- Safe string and memory manipulation functions ---
 #include <stdarg.h>
@@ -0,0 +1,559 @@
+#define _POSIX_C_SOURCE 200809L
+#include "writer.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+// Tasks purged, change log entries scanned and pages released by one
+// maintenance step
+#define PURGE_BATCH_SIZE 500
+#define PRUNE_BATCH_SIZE 5000
+#define VACUUM_STEP_PAGES 256
+
+// Latest changes kept in the change log, deletions included, for the other
+// instances sharing the database. Those further behind reload their view.
+#define CHANGE_LOG_KEEP 10000
+
+// A queued mutation. The writer thread fills `ack` and moves the command to
+// the done list, so posting an acknowledgement never allocates.
+struct WriteCommand {
+  WriteCommand *next;
+  DatabaseWrite op;
+  int count;         // Number of tasks
+  int *task_ids;     // May hold provisional IDs
+  int *statuses;     // New status of each task (DB_WRITE_TOGGLE)
+  bool *deferred;    // Tasks whose committed row goes back in the ack
+  char *description; // DB_WRITE_ADD and DB_WRITE_EDIT
+  TrashRetention retention; // DB_WRITE_PURGE
+  WriteAck ack;
+};
+
+// Frees the rows of an ack, along with their descriptions.
+static void free_rows(WriteAck *ack) {
+  if (ack->rows) {
+    task_list_free(ack->rows);
+    free(ack->rows);
+    ack->rows = NULL;
+  }
+}
+
+static void free_command(WriteCommand *cmd) {
+  free(cmd->task_ids);
+  free(cmd->statuses);
+  free(cmd->deferred);
+  free(cmd->description);
+  free_rows(&cmd->ack);
+  free(cmd);
+}
+
+static WriteCommand *new_command(DatabaseWrite op, const int *task_ids,
+                                 int count, const char *description) {
+  WriteCommand *cmd = calloc(1, sizeof(WriteCommand));
+  if (!cmd)
+    return NULL;
+  cmd->op = op;
+  cmd->count = count;
+  cmd->task_ids = malloc(sizeof(int) * (size_t)count);
+  cmd->statuses = calloc((size_t)count, sizeof(int));
+  cmd->deferred = calloc((size_t)count, sizeof(bool));
+  if (description)
+    cmd->description = strdup(description);
+  if (!cmd->task_ids || !cmd->statuses || !cmd->deferred ||
+      (description && !cmd->description)) {
+    free_command(cmd);
+    return NULL;
+  }
+  safe_memcpy(cmd->task_ids, task_ids, sizeof(int) * (size_t)count);
+  return cmd;
+}
+
+// --- Writer Thread ---
+
+// Returns the database ID of a task that may still have a provisional ID.
+static int real_id(const Writer *w, int task_id) {
+  if (task_id < WRITER_PROVISIONAL_ID_BASE)
+    return task_id;
+  for (int i = 0; i < w->id_map_count; i++) {
+    if (w->id_map[2 * i] == task_id)
+      return w->id_map[2 * i + 1];
+  }
+  return task_id; // The add failed; the mutation will not find the task
+}
+
+static void map_id(Writer *w, int provisional_id, int task_id) {
+  if (w->id_map_count == w->id_map_capacity) {
+    int new_capacity = w->id_map_capacity ? w->id_map_capacity * 2 : 16;
+    int *new_map = realloc(w->id_map, sizeof(int) * 2 * (size_t)new_capacity);
+    if (!new_map)
+      return;
+    w->id_map = new_map;
+    w->id_map_capacity = new_capacity;
+  }
+  w->id_map[2 * w->id_map_count] = provisional_id;
+  w->id_map[2 * w->id_map_count + 1] = task_id;
+  w->id_map_count++;
+}
+
+// Drops the pairs of provisional IDs up to `acked_id`. The UI renames a task
+// as soon as it collects the ack of its insert, so only commands queued before
+// that still carry the provisional ID. The map is in insertion order, which is
+// the order the provisional IDs were handed out.
+static void unmap_ids(Writer *w, int acked_id) {
+  int keep = 0;
+  while (keep < w->id_map_count && w->id_map[2 * keep] <= acked_id)
+    keep++;
+  w->id_map_count -= keep;
+  safe_memmove(w->id_map, w->id_map + 2 * keep,
+               sizeof(int) * 2 * (size_t)w->id_map_count);
+}
+
+// Runs one queued mutation inside the group transaction and fills its ack.
+// Returns false on an error that leaves the transaction unusable.
+static bool run_command(Writer *w, WriteCommand *cmd) {
+  WriteAck *ack = &cmd->ack;
+  Task row;
+
+  if (cmd->op == DB_WRITE_PURGE) {
+    bool more_changes = false;
+    bool more_pages = false;
+    ack->result = database_purge_trash(&w->db, &cmd->retention,
+                                       PURGE_BATCH_SIZE, &ack->purged);
+    if (ack->result == ORDO_OK)
+      ack->result = database_prune_changes(&w->db, CHANGE_LOG_KEEP,
+                                           PRUNE_BATCH_SIZE, &more_changes);
+    if (ack->result == ORDO_OK)
+      ack->result =
+          database_vacuum_step(&w->db, VACUUM_STEP_PAGES, &more_pages);
+    ack->more =
+        ack->purged == PURGE_BATCH_SIZE || more_changes || more_pages;
+    return ack->result == ORDO_OK;
+  }
+
+  if (cmd->op == DB_WRITE_ADD) {
+    ack->provisional_id = cmd->task_ids[0];
+    ack->result = database_write_row(&w->db, DB_WRITE_ADD, 0, 0,
+                                     cmd->description, &row);
+    if (ack->result != ORDO_OK)
+      return false;
+    ack->task_id = row.id;
+    map_id(w, ack->provisional_id, row.id);
+    return true;
+  }
+
+  int written = 0;
+  ack->result = ORDO_OK;
+  for (int i = 0; i < cmd->count; i++) {
+    OrdoResult result =
+        database_write_row(&w->db, cmd->op, real_id(w, cmd->task_ids[i]),
+                           cmd->statuses[i], cmd->description, &row);
+    if (result == ORDO_ERROR_TASK_NOT_FOUND) {
+      ack->missing++;
+      continue;
+    }
+    if (result != ORDO_OK) {
+      ack->result = result;
+      return false;
+    }
+    written++;
+    if (cmd->deferred[i]) {
+      // The row's description only lives until the next write; the ack's
+      // own list keeps a copy.
+      if (!ack->rows && (ack->rows = malloc(sizeof(TaskList))))
+        task_list_init(ack->rows);
+      if (ack->rows)
+        task_list_add(ack->rows, &row);
+    }
+  }
+  if (written == 0)
+    ack->result = ORDO_ERROR_TASK_NOT_FOUND;
+  return true;
+}
+
+// Writes a group of mutations in a single transaction. If the transaction
+// fails, none of them is committed and every ack reports the failure.
+static void write_group(Writer *w, WriteCommand *group) {
+  int map_mark = w->id_map_count;
+  bool ok = database_begin(&w->db) == ORDO_OK;
+
+  for (WriteCommand *cmd = group; cmd; cmd = cmd->next) {
+    cmd->ack.result = ORDO_ERROR_DATABASE;
+    if (ok && !run_command(w, cmd))
+      ok = false;
+  }
+
+  if (ok && database_commit(&w->db) != ORDO_OK)
+    ok = false;
+  if (!ok) {
+    if (!sqlite3_get_autocommit(w->db.db))
+      database_rollback(&w->db);
+    // The IDs of rolled back inserts may be handed out again.
+    w->id_map_count = map_mark;
+    for (WriteCommand *cmd = group; cmd; cmd = cmd->next) {
+      if (cmd->ack.result == ORDO_OK)
+        cmd->ack.result = ORDO_ERROR_DATABASE;
+      free_rows(&cmd->ack);
+    }
+  }
+}
+
+// Wakes the UI thread's event loop.
+static void notify(Writer *w) {
+#ifndef _WIN32
+  if (w->notify_fds[1] >= 0) {
+    char byte = 0;
+    // A full pipe is readable already, so a failed write loses nothing.
+    if (write(w->notify_fds[1], &byte, 1) < 0)
+      return;
+  }
+#else
+  (void)w;
+#endif
+}
+
+static void *writer_main(void *arg) {
+  Writer *w = arg;
+
+  pthread_mutex_lock(&w->lock);
+  for (;;) {
+    while (!w->head && !w->stop)
+      pthread_cond_wait(&w->wake, &w->lock);
+    WriteCommand *group = w->head;
+    if (!group)
+      break; // Stopping and nothing left to write
+    WriteCommand *group_tail = w->tail;
+    w->head = w->tail = NULL;
+    int acked_id = w->acked_provisional_id;
+    pthread_mutex_unlock(&w->lock);
+
+    // Everything queued while the previous group was committing is written
+    // in one transaction. Any command still using a provisional ID the UI
+    // already knows the real one of is in this group or an earlier one.
+    write_group(w, group);
+    unmap_ids(w, acked_id);
+    int count = 0;
+    for (WriteCommand *cmd = group; cmd; cmd = cmd->next)
+      count++;
+
+    pthread_mutex_lock(&w->lock);
+    if (w->done_tail) {
+      w->done_tail->next = group;
+    } else {
+      w->done_head = group;
+      notify(w); // The UI collects every ack once woken, so once is enough
+    }
+    w->done_tail = group_tail;
+    w->pending -= count;
+    if (w->pending == 0)
+      pthread_cond_broadcast(&w->idle);
+  }
+  pthread_mutex_unlock(&w->lock);
+  return NULL;
+}
+
+// --- Lifecycle Functions ---
+
+// Opens the pipe the writer thread signals its acknowledgements on. Without
+// it, the UI has to poll for them.
+static void open_notify_pipe(Writer *writer) {
+#ifndef _WIN32
+  if (pipe(writer->notify_fds) != 0) {
+    writer->notify_fds[0] = writer->notify_fds[1] = -1;
+    return;
+  }
+  for (int i = 0; i < 2; i++) {
+    fcntl(writer->notify_fds[i], F_SETFL, O_NONBLOCK);
+    fcntl(writer->notify_fds[i], F_SETFD, FD_CLOEXEC);
+  }
+#else
+  (void)writer;
+#endif
+}
+
+static void close_notify_pipe(Writer *writer) {
+#ifndef _WIN32
+  for (int i = 0; i < 2; i++) {
+    if (writer->notify_fds[i] >= 0)
+      close(writer->notify_fds[i]);
+  }
+#endif
+  writer->notify_fds[0] = writer->notify_fds[1] = -1;
+}
+
+OrdoResult writer_start(Writer *writer, Database *db) {
+  *writer = (Writer){0};
+  writer->db = *db;
+  writer->next_provisional_id = WRITER_PROVISIONAL_ID_BASE;
+  pthread_mutex_init(&writer->lock, NULL);
+  pthread_cond_init(&writer->wake, NULL);
+  pthread_cond_init(&writer->idle, NULL);
+  open_notify_pipe(writer);
+
+#ifndef _WIN32
+  // Signals are for the UI thread, whose wait they must interrupt; the
+  // thread inherits a mask that blocks them all.
+  sigset_t all, previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+#endif
+  int error = pthread_create(&writer->thread, NULL, writer_main, writer);
+#ifndef _WIN32
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+#endif
+  if (error != 0) {
+    close_notify_pipe(writer);
+    database_close(&writer->db);
+    return ORDO_ERROR_GENERIC;
+  }
+  writer->started = true;
+  return ORDO_OK;
+}
+
+void writer_stop(Writer *writer) {
+  if (!writer->started)
+    return;
+
+  pthread_mutex_lock(&writer->lock);
+  writer->stop = true;
+  pthread_cond_signal(&writer->wake);
+  pthread_mutex_unlock(&writer->lock);
+  pthread_join(writer->thread, NULL);
+  writer->started = false;
+
+  while (writer->done_head) {
+    WriteCommand *next = writer->done_head->next;
+    free_command(writer->done_head);
+    writer->done_head = next;
+  }
+  writer->done_tail = NULL;
+  free(writer->id_map);
+  writer->id_map = NULL;
+  close_notify_pipe(writer);
+  database_close(&writer->db);
+  pthread_cond_destroy(&writer->idle);
+  pthread_cond_destroy(&writer->wake);
+  pthread_mutex_destroy(&writer->lock);
+}
+
+bool writer_busy(Writer *writer) {
+  pthread_mutex_lock(&writer->lock);
+  bool busy = writer->pending > 0 || writer->done_head != NULL;
+  pthread_mutex_unlock(&writer->lock);
+  return busy;
+}
+
+int writer_event_fd(const Writer *writer) { return writer->notify_fds[0]; }
+
+void writer_flush(Writer *writer) {
+  pthread_mutex_lock(&writer->lock);
+  while (writer->pending > 0)
+    pthread_cond_wait(&writer->idle, &writer->lock);
+  pthread_mutex_unlock(&writer->lock);
+}
+
+bool writer_poll_ack(Writer *writer, WriteAck *ack) {
+  pthread_mutex_lock(&writer->lock);
+  WriteCommand *cmd = writer->done_head;
+  if (cmd) {
+    writer->done_head = cmd->next;
+    if (!writer->done_head)
+      writer->done_tail = NULL;
+    if (cmd->ack.op == DB_WRITE_ADD && cmd->ack.result == ORDO_OK)
+      writer->acked_provisional_id = cmd->ack.provisional_id;
+  }
+  pthread_mutex_unlock(&writer->lock);
+
+  if (!cmd)
+    return false;
+  *ack = cmd->ack;
+  cmd->ack.rows = NULL; // Now owned by the caller
+  free_command(cmd);
+  return true;
+}
+
+void writer_apply_ack(const WriteAck *ack, TaskList *cache) {
+  if (ack->result != ORDO_OK || !cache)
+    return;
+
+  if (ack->op == DB_WRITE_ADD) {
+    // The real ID is the highest so far, so the list stays sorted.
+    task_list_rename(cache, ack->provisional_id, ack->task_id);
+    return;
+  }
+
+  for (int i = 0; ack->rows && i < ack->rows->count; i++) {
+    const Task *row = &ack->rows->tasks[i];
+    switch (ack->op) {
+    case DB_WRITE_PERM_DELETE:
+      task_list_forget(cache, row->id, row->is_deleted);
+      break;
+    case DB_WRITE_REMOVE:
+      task_list_apply(cache, row, 0);
+      break;
+    case DB_WRITE_RESTORE:
+      task_list_apply(cache, row, 1);
+      break;
+    default:
+      task_list_apply(cache, row, row->is_deleted);
+      break;
+    }
+  }
+}
+
+void writer_free_ack(WriteAck *ack) {
+  free_rows(ack);
+}
+
+// --- Mutation Functions ---
+
+// Patches the cached row of a task the way `op` will change it. Returns false
+// if the task is not in the list; its committed row then comes back in the
+// ack and is applied by `writer_apply_ack`.
+static bool patch_cached(TaskList *cache, DatabaseWrite op, int task_id,
+                         int status, const char *description) {
+  int index = cache ? task_list_find(cache, task_id) : -1;
+  if (index < 0)
+    return false;
+
+  Task expected = cache->tasks[index];
+  int was_deleted = expected.is_deleted;
+  switch (op) {
+  case DB_WRITE_REMOVE:
+    expected.is_deleted = 1;
+    break;
+  case DB_WRITE_RESTORE:
+    expected.is_deleted = 0;
+    break;
+  case DB_WRITE_PERM_DELETE:
+    task_list_forget(cache, task_id, was_deleted);
+    return true;
+  case DB_WRITE_TOGGLE:
+    expected.concluida = status;
+    break;
+  case DB_WRITE_EDIT:
+    expected.descricao = description;
+    break;
+  case DB_WRITE_ADD:
+  case DB_WRITE_PURGE:
+    return true;
+  }
+  task_list_apply(cache, &expected, was_deleted);
+  return true;
+}
+
+// Patches the cache for every task of `cmd` and hands it to the writer thread.
+static OrdoResult queue_command(Writer *writer, WriteCommand *cmd,
+                                TaskList *cache, unsigned long *seq) {
+  for (int i = 0; i < cmd->count; i++) {
+    cmd->deferred[i] =
+        cache && !patch_cached(cache, cmd->op, cmd->task_ids[i],
+                               cmd->statuses[i], cmd->description);
+  }
+
+  pthread_mutex_lock(&writer->lock);
+  cmd->ack.seq = ++writer->next_seq;
+  cmd->ack.op = cmd->op;
+  if (writer->tail)
+    writer->tail->next = cmd;
+  else
+    writer->head = cmd;
+  writer->tail = cmd;
+  writer->pending++;
+  pthread_cond_signal(&writer->wake);
+  pthread_mutex_unlock(&writer->lock);
+
+  if (seq)
+    *seq = cmd->ack.seq;
+  return ORDO_OK;
+}
+
+OrdoResult writer_add_task(Writer *writer, const char *description,
+                           int *provisional_id, TaskList *cache,
+                           unsigned long *seq) {
+  if (description == NULL || strlen(description) == 0) {
+    return ORDO_ERROR_EMPTY_DESCRIPTION;
+  }
+
+  int id = writer->next_provisional_id++;
+  WriteCommand *cmd = new_command(DB_WRITE_ADD, &id, 1, description);
+  if (!cmd)
+    return ORDO_ERROR_GENERIC;
+
+  Task row = {.id = id, .descricao = description};
+  if (cache)
+    task_list_apply(cache, &row, TASK_LIST_NEW_ROW);
+  *provisional_id = id;
+  return queue_command(writer, cmd, NULL, seq);
+}
+
+// Queues the same kind of mutation for several tasks
+static OrdoResult queue_tasks(Writer *writer, DatabaseWrite op,
+                              const int *task_ids, int count,
+                              TaskList *cache, unsigned long *seq) {
+  if (count <= 0)
+    return ORDO_ERROR_TASK_NOT_FOUND;
+  WriteCommand *cmd = new_command(op, task_ids, count, NULL);
+  if (!cmd)
+    return ORDO_ERROR_GENERIC;
+  return queue_command(writer, cmd, cache, seq);
+}
+
+OrdoResult writer_remove_tasks(Writer *writer, const int *task_ids, int count,
+                               TaskList *cache, unsigned long *seq) {
+  return queue_tasks(writer, DB_WRITE_REMOVE, task_ids, count, cache, seq);
+}
+
+OrdoResult writer_restore_tasks(Writer *writer, const int *task_ids, int count,
+                                TaskList *cache, unsigned long *seq) {
+  return queue_tasks(writer, DB_WRITE_RESTORE, task_ids, count, cache, seq);
+}
+
+OrdoResult writer_permanently_delete_tasks(Writer *writer, const int *task_ids,
+                                           int count, TaskList *cache,
+                                           unsigned long *seq) {
+  return queue_tasks(writer, DB_WRITE_PERM_DELETE, task_ids, count, cache,
+                     seq);
+}
+
+OrdoResult writer_toggle_tasks_status(Writer *writer, const int *task_ids,
+                                      const int *current_statuses, int count,
+                                      TaskList *cache, unsigned long *seq) {
+  if (count <= 0)
+    return ORDO_ERROR_TASK_NOT_FOUND;
+  WriteCommand *cmd = new_command(DB_WRITE_TOGGLE, task_ids, count, NULL);
+  if (!cmd)
+    return ORDO_ERROR_GENERIC;
+  for (int i = 0; i < count; i++)
+    cmd->statuses[i] = !current_statuses[i];
+  return queue_command(writer, cmd, cache, seq);
+}
+
+OrdoResult writer_update_task_description(Writer *writer, int task_id,
+                                          const char *new_description,
+                                          TaskList *cache,
+                                          unsigned long *seq) {
+  if (new_description == NULL || strlen(new_description) == 0) {
+    return ORDO_ERROR_EMPTY_DESCRIPTION;
+  }
+  WriteCommand *cmd = new_command(DB_WRITE_EDIT, &task_id, 1, new_description);
+  if (!cmd)
+    return ORDO_ERROR_GENERIC;
+  return queue_command(writer, cmd, cache, seq);
+}
+
+// --- Maintenance Functions ---
+
+OrdoResult writer_purge_trash(Writer *writer, const TrashRetention *policy,
+                              unsigned long *seq) {
+  WriteCommand *cmd = calloc(1, sizeof(WriteCommand));
+  if (!cmd)
+    return ORDO_ERROR_GENERIC;
+  cmd->op = DB_WRITE_PURGE;
+  cmd->retention = *policy;
+  return queue_command(writer, cmd, NULL, seq);
+}
@@ -0,0 +1,249 @@
+/**
+ * @file writer.h
+ * @brief Background thread that writes task mutations to the database.
+ *
+ * The UI thread patches its task list optimistically and queues the mutation.
+ * The writer drains the queue on its own SQLite connection, commits everything
+ * queued so far in one transaction (group commit) and posts one
+ * acknowledgement per mutation, which the UI thread collects with
+ * `writer_poll_ack`. The UI therefore never waits for a commit to reach the
+ * disk.
+ *
+ * A new task is shown with a provisional ID until its acknowledgement carries
+ * the ID assigned by the database. Mutations queued in the meantime may use
+ * the provisional ID; the writer translates it.
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "database.h"
+#include "error.h"
+#include "task.h"
+#include "task_list.h"
+#include <pthread.h>
+#include <stdbool.h>
+
+/** First provisional ID. Provisional IDs sort after every real ID. */
+#define WRITER_PROVISIONAL_ID_BASE (1 << 30)
+
+typedef struct WriteCommand WriteCommand;
+
+/**
+ * @struct WriteAck
+ * @brief The outcome of one queued mutation.
+ */
+typedef struct {
+  unsigned long seq;  /**< Sequence number returned when the mutation was queued. */
+  DatabaseWrite op;   /**< The kind of mutation. */
+  OrdoResult result;  /**< `ORDO_OK` if the mutation was committed. */
+  int provisional_id; /**< For `DB_WRITE_ADD`, the ID the task was shown with. */
+  int task_id;        /**< For `DB_WRITE_ADD`, the ID assigned by the database. */
+  int missing;        /**< The number of tasks that no longer matched. */
+  TaskList *rows;     /**< The committed rows of the tasks that were not in the list when queued, or `NULL`. */
+  int purged;         /**< For `DB_WRITE_PURGE`, the tasks deleted for good. */
+  bool more;          /**< For `DB_WRITE_PURGE`, whether another step has work left. */
+} WriteAck;
+
+/**
+ * @struct Writer
+ * @brief The writer thread, its connection and its queues.
+ */
+typedef struct {
+  Database db;              /**< The writer's own connection. */
+  pthread_t thread;         /**< The writer thread. */
+  pthread_mutex_t lock;     /**< Guards both lists, `pending`, `next_seq`, `acked_provisional_id` and `stop`. */
+  pthread_cond_t wake;      /**< Signalled when a mutation is queued or on stop. */
+  pthread_cond_t idle;      /**< Signalled when every queued mutation is written. */
+  WriteCommand *head;       /**< First queued mutation. */
+  WriteCommand *tail;       /**< Last queued mutation. */
+  WriteCommand *done_head;  /**< First written mutation whose acknowledgement was not collected. */
+  WriteCommand *done_tail;  /**< Last written mutation. */
+  int pending;              /**< Mutations queued or being written. */
+  unsigned long next_seq;   /**< Sequence number of the next mutation. */
+  int next_provisional_id;  /**< Provisional ID of the next new task (UI thread). */
+  int acked_provisional_id; /**< Highest provisional ID whose acknowledgement was collected. */
+  int *id_map;              /**< Provisional/real ID pairs not yet known to the UI (writer thread). */
+  int id_map_count;         /**< The number of pairs in `id_map`. */
+  int id_map_capacity;      /**< The capacity of `id_map`, in pairs. */
+  int notify_fds[2];        /**< Pipe written when acknowledgements are posted, or -1. */
+  bool stop;                /**< Set to make the thread exit once the queue is empty. */
+  bool started;             /**< Whether the thread is running. */
+} Writer;
+
+// --- Lifecycle Functions ---
+
+/**
+ * @brief Starts the writer thread.
+ * @param[out] writer Pointer to the `Writer` to be started.
+ * @param[in] db An initialized `Database` on its own connection. The writer
+ * takes ownership of it, also on failure.
+ * @return `ORDO_OK` on success.
+ */
+OrdoResult writer_start(Writer *writer, Database *db);
+
+/**
+ * @brief Writes every queued mutation, stops the thread and closes its
+ * connection.
+ * @param[in] writer Pointer to the `Writer`.
+ */
+void writer_stop(Writer *writer);
+
+/**
+ * @brief Checks whether mutations are in flight or acknowledgements are
+ * waiting to be collected.
+ * @param[in] writer Pointer to the `Writer`.
+ * @return `true` if the UI should poll for acknowledgements.
+ */
+bool writer_busy(Writer *writer);
+
+/**
+ * @brief Returns a descriptor that becomes readable when acknowledgements are
+ * posted, so the UI can sleep until then instead of polling.
+ *
+ * The caller empties it before collecting the acknowledgements; reading it
+ * never blocks.
+ * @param[in] writer Pointer to the `Writer`.
+ * @return The descriptor, or -1 if the UI has to poll with `writer_busy`.
+ */
+int writer_event_fd(const Writer *writer);
+
+/**
+ * @brief Blocks until every queued mutation has been written.
+ *
+ * Call before reading from the database on another connection, so that the
+ * read sees the optimistic changes already shown.
+ * @param[in] writer Pointer to the `Writer`.
+ */
+void writer_flush(Writer *writer);
+
+/**
+ * @brief Takes the oldest uncollected acknowledgement.
+ *
+ * Once the acknowledgement of a `DB_WRITE_ADD` is collected, the writer
+ * forgets the task's provisional ID: mutations queued from then on must use
+ * the ID the database assigned.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[out] ack Receives the acknowledgement; release it with
+ * `writer_free_ack`.
+ * @return `false` if there was none.
+ */
+bool writer_poll_ack(Writer *writer, WriteAck *ack);
+
+/**
+ * @brief Applies a successful acknowledgement to a task list.
+ *
+ * Replaces the provisional ID of a new task and patches the rows that were not
+ * in the list when the mutation was queued.
+ * @param[in] ack The acknowledgement.
+ * @param[in,out] cache The task list the mutation was queued against.
+ */
+void writer_apply_ack(const WriteAck *ack, TaskList *cache);
+
+/**
+ * @brief Frees the memory owned by an acknowledgement.
+ * @param[in] ack The acknowledgement.
+ */
+void writer_free_ack(WriteAck *ack);
+
+// --- Mutation Functions ---
+// Each function patches `cache` for the tasks it holds, queues the mutation
+// and returns at once. `seq` receives the sequence number its acknowledgement
+// will carry. A failure reported later by the acknowledgement leaves `cache`
+// out of date; the caller is expected to reload it.
+
+/**
+ * @brief Queues a new task.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] description The description of the new task.
+ * @param[out] provisional_id Receives the ID the task has until it is written.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_add_task(Writer *writer, const char *description,
+                           int *provisional_id, TaskList *cache,
+                           unsigned long *seq);
+
+/**
+ * @brief Queues moving tasks to the trash.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] task_ids The IDs of the tasks.
+ * @param[in] count The number of IDs.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_remove_tasks(Writer *writer, const int *task_ids, int count,
+                               TaskList *cache, unsigned long *seq);
+
+/**
+ * @brief Queues restoring tasks from the trash.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] task_ids The IDs of the tasks.
+ * @param[in] count The number of IDs.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_restore_tasks(Writer *writer, const int *task_ids, int count,
+                                TaskList *cache, unsigned long *seq);
+
+/**
+ * @brief Queues deleting tasks permanently.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] task_ids The IDs of the tasks.
+ * @param[in] count The number of IDs.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_permanently_delete_tasks(Writer *writer, const int *task_ids,
+                                           int count, TaskList *cache,
+                                           unsigned long *seq);
+
+/**
+ * @brief Queues toggling the status of tasks.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] task_ids The IDs of the tasks.
+ * @param[in] current_statuses The current status of each task.
+ * @param[in] count The number of IDs.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_toggle_tasks_status(Writer *writer, const int *task_ids,
+                                      const int *current_statuses, int count,
+                                      TaskList *cache, unsigned long *seq);
+
+/**
+ * @brief Queues replacing the description of a task.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] task_id The ID of the task.
+ * @param[in] new_description The new description.
+ * @param[in,out] cache The task list to patch, or `NULL`.
+ * @param[out] seq Receives the sequence number of the mutation.
+ * @return `ORDO_OK` if the mutation was queued.
+ */
+OrdoResult writer_update_task_description(Writer *writer, int task_id,
+                                          const char *new_description,
+                                          TaskList *cache, unsigned long *seq);
+
+// --- Maintenance Functions ---
+
+/**
+ * @brief Queues one bounded step of trash maintenance: purging a batch of the
+ * tasks the retention policy no longer keeps, pruning a batch of the change
+ * log and releasing a batch of free pages.
+ *
+ * The acknowledgement tells whether another step has work left. Rows purged
+ * from the list's view are picked up by `database_sync_changes`.
+ * @param[in] writer Pointer to the `Writer`.
+ * @param[in] policy The retention policy.
+ * @param[out] seq Receives the sequence number of the step, or `NULL`.
+ * @return `ORDO_OK` if the step was queued.
+ */
+OrdoResult writer_purge_trash(Writer *writer, const TrashRetention *policy,
+                              unsigned long *seq);
+
+#endif // WRITER_H